@@ -0,0 +1,228 @@
+// g++ -O2 -std=c++20 -Iinclude bench/await_chain.cpp -o await_chain -pthread
+//
+// co_await chains of coro::task, which resumes its awaiter by symmetric
+// transfer, against a task which resumes it from inside await_suspend() /
+// final_suspend() like the naive task of coro-basic/symmetric.cpp before
+// symmetric transfer: every synchronous completion nests two stack frames
+// and a million of them overflow the default 8 MiB stack. the recursive
+// runs are forked, a crash only ends the child.
+//
+// symmetric transfer needs the compiler to turn the resume() of the
+// returned handle into a tail call: at -O0 or with -fsanitize=address the
+// deep chains overflow as well
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <coroutine>
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// the recursive version: resume() inside await_suspend() runs the task on
+// top of its awaiter, the final awaiter resumes the awaiter on top of both
+class recursive_task {
+ public:
+  struct promise_type : coro::pooled_frame {
+    recursive_task get_return_object() noexcept {
+      return recursive_task{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    struct final_awaiter {
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+        if (auto continuation = h.promise().continuation) {
+          continuation.resume();
+        }
+      }
+      void await_resume() noexcept {}
+    };
+    final_awaiter final_suspend() noexcept { return {}; }
+    void return_value(int v) noexcept { value = v; }
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    std::coroutine_handle<> continuation;
+    int value = 0;
+  };
+
+  recursive_task(recursive_task&& t) noexcept
+      : coro_{std::exchange(t.coro_, {})} {}
+  ~recursive_task() {
+    if (coro_) {
+      coro_.destroy();
+    }
+  }
+
+  auto operator co_await() && noexcept {
+    struct awaiter {
+      std::coroutine_handle<promise_type> coro;
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> continuation) noexcept {
+        coro.promise().continuation = continuation;
+        coro.resume();
+      }
+      int await_resume() noexcept { return coro.promise().value; }
+    };
+    return awaiter{coro_};
+  }
+
+  // runs it to completion on the calling thread
+  int run() {
+    coro_.resume();
+    return coro_.promise().value;
+  }
+
+ private:
+  explicit recursive_task(std::coroutine_handle<promise_type> h) noexcept
+      : coro_{h} {}
+  std::coroutine_handle<promise_type> coro_;
+};
+
+coro::task<int> completes_synchronously() {
+  co_return 1;
+}
+coro::task<int> loop_synchronously(int count) {
+  int sum = 0;
+  for (int i = 0; i < count; ++i) {
+    sum += co_await completes_synchronously();
+  }
+  co_return sum;
+}
+// count frames alive at once
+coro::task<int> chain(int depth) {
+  if (depth == 0) {
+    co_return 0;
+  }
+  co_return co_await chain(depth - 1) + 1;
+}
+
+recursive_task recursive_completes_synchronously() {
+  co_return 1;
+}
+recursive_task recursive_loop_synchronously(int count) {
+  int sum = 0;
+  for (int i = 0; i < count; ++i) {
+    sum += co_await recursive_completes_synchronously();
+  }
+  co_return sum;
+}
+recursive_task recursive_chain(int depth) {
+  if (depth == 0) {
+    co_return 0;
+  }
+  co_return co_await recursive_chain(depth - 1) + 1;
+}
+
+template <typename F>
+double seconds(F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void report(const char* name, int n, double secs) {
+  std::printf("  %-22s %9d  %8.2f ms  %7.1f ns/await\n", name, n,
+              secs * 1e3, secs * 1e9 / n);
+}
+
+template <typename F>
+void symmetric(const char* name, int n, F&& make) {
+  int result = 0;
+  auto secs = seconds([&] { result = coro::sync_wait(make(n)); });
+  if (result != n) {
+    std::printf("  %-22s %9d  wrong result %d\n", name, n, result);
+    return;
+  }
+  report(name, n, secs);
+}
+
+// in a child, on the default stack, so that an overflow is reported
+template <typename F>
+void recursive(const char* name, int n, F&& make) {
+  std::fflush(stdout);
+  auto pid = ::fork();
+  if (pid == 0) {
+    int result = 0;
+    auto secs = seconds([&] { result = make(n).run(); });
+    if (result != n) {
+      std::printf("  %-22s %9d  wrong result %d\n", name, n, result);
+    } else {
+      report(name, n, secs);
+    }
+    std::fflush(stdout);
+    ::_exit(0);
+  }
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  if (WIFSIGNALED(status)) {
+    std::printf("  %-22s %9d  stack overflow (signal %d)\n", name, n,
+                WTERMSIG(status));
+  }
+}
+
+coro::task<int> leaf(coro::static_thread_pool& pool, int depth) {
+  co_await pool.schedule();
+  co_return co_await chain(depth);
+}
+coro::task<int> fan_out(coro::static_thread_pool& pool, int width, int depth) {
+  std::vector<coro::task<int>> children;
+  for (int i = 0; i < width; ++i) {
+    children.push_back(leaf(pool, depth));
+  }
+  // a value, not a reference into the promise of the temporary task
+  auto values = co_await coro::when_all(std::move(children));
+  int sum = 0;
+  for (auto value : values) {
+    sum += value;
+  }
+  co_return sum;
+}
+
+}  // namespace
+
+int main() {
+  std::printf("co_await of a task completing synchronously, in a loop\n");
+  for (int n : {1000, 100'000, 1'000'000}) {
+    symmetric("symmetric transfer", n, loop_synchronously);
+    recursive("recursive resume", n, recursive_loop_synchronously);
+  }
+
+  std::printf("chain of n nested co_await\n");
+  for (int n : {1000, 100'000, 1'000'000}) {
+    symmetric("symmetric transfer", n, chain);
+    recursive("recursive resume", n, recursive_chain);
+  }
+
+  // children starting with co_await pool.schedule() run concurrently
+  coro::static_thread_pool pool;
+  constexpr int kWidth = 64;
+  constexpr int kDepth = 10'000;
+  int sum = 0;
+  auto secs = seconds(
+      [&] { sum = coro::sync_wait(fan_out(pool, kWidth, kDepth)); });
+  std::printf("when_all of %d chains of %d on %zu threads: %s, %.2f ms\n",
+              kWidth, kDepth, pool.thread_count(),
+              sum == kWidth * kDepth ? "ok" : "wrong result", secs * 1e3);
+
+  auto [a, b, c] = coro::sync_wait(coro::when_all(
+      chain(1), [&]() -> coro::task<> { co_await pool.schedule(); }(),
+      leaf(pool, 2)));
+  std::printf("when_all(int, void, int): %d %d\n", a, c);
+  (void)b;
+
+  auto stats = coro::frame_pool::stats();
+  std::printf("frame pool: %llu frames, hit rate %.1f%%\n",
+              static_cast<unsigned long long>(stats.allocations),
+              stats.hit_rate() * 100);
+  return 0;
+}
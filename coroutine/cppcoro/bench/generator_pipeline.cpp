@@ -0,0 +1,217 @@
+// g++ -O2 -std=c++20 -Iinclude bench/generator_pipeline.cpp -o generator_pipeline -pthread
+// ./generator_pipeline [records]
+//
+// the same record pipeline, filter | transform | take | batch, over 100M
+// generated records by default:
+// - generator: the stages run in the consumer's loop
+// - async_generator: the stages run in one fused frame, the consumer
+//   co_awaits every batch
+// - task per record: a task<> is co_awaited for every record, one frame
+//   each, from the frame pool
+// - vector: every stage materializes its whole output before the next one
+// every variant runs in a child, for its own peak RSS
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cppcoro/async_generator.hpp>
+#include <cppcoro/generator.hpp>
+#include <cppcoro/pipeline.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/task.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Record {
+  std::uint64_t key;
+  std::uint32_t size;
+  std::uint32_t kind;
+};
+
+constexpr std::size_t kBatch = 4096;
+
+// xorshift64: the records cost a few cycles to make, like a parser's
+Record make_record(std::uint64_t& state) noexcept {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return {state, static_cast<std::uint32_t>(state >> 40) & 0xfff,
+          static_cast<std::uint32_t>(state) & 3};
+}
+bool keep(const Record& r) noexcept {
+  return r.kind != 0;
+}
+std::uint64_t weigh(const Record& r) noexcept {
+  return (r.key >> 3) * r.size;
+}
+
+struct Result {
+  std::uint64_t sum = 0;
+  std::uint64_t count = 0;
+  std::uint64_t batches = 0;
+
+  void add(const std::vector<std::uint64_t>& batch) noexcept {
+    for (auto value : batch) {
+      sum += value;
+    }
+    count += batch.size();
+    ++batches;
+  }
+};
+
+coro::generator<Record> records(std::size_t n) {
+  std::uint64_t state = 88172645463325252ull;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto record = make_record(state);
+    co_yield record;
+  }
+}
+
+coro::async_generator<Record> async_records(std::size_t n) {
+  std::uint64_t state = 88172645463325252ull;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto record = make_record(state);
+    co_yield record;
+  }
+}
+
+Result run_generator(std::size_t n, std::size_t limit) {
+  Result result;
+  for (auto& batch : records(n) | coro::filter(keep) |
+                         coro::transform(weigh) | coro::take(limit) |
+                         coro::batch(kBatch)) {
+    result.add(batch);
+  }
+  return result;
+}
+
+coro::task<Result> consume_async(std::size_t n, std::size_t limit) {
+  Result result;
+  auto batches = async_records(n) | coro::filter(keep) |
+                 coro::transform(weigh) | coro::take(limit) |
+                 coro::batch(kBatch);
+  for (auto it = co_await batches.begin(); it != batches.end();
+       co_await ++it) {
+    result.add(*it);
+  }
+  co_return result;
+}
+Result run_async_generator(std::size_t n, std::size_t limit) {
+  return coro::sync_wait(consume_async(n, limit));
+}
+
+// what a record costs as a task of its own
+coro::task<bool> process(const Record& record,
+                         std::vector<std::uint64_t>& batch) {
+  if (keep(record)) {
+    batch.push_back(weigh(record));
+    co_return true;
+  }
+  co_return false;
+}
+coro::task<Result> consume_tasks(std::size_t n, std::size_t limit) {
+  Result result;
+  std::vector<std::uint64_t> batch;
+  batch.reserve(kBatch);
+  std::uint64_t state = 88172645463325252ull;
+  std::size_t taken = 0;
+  for (std::size_t i = 0; i < n && taken < limit; ++i) {
+    auto record = make_record(state);
+    if (co_await process(record, batch)) {
+      ++taken;
+    }
+    if (batch.size() == kBatch) {
+      result.add(batch);
+      batch.clear();
+    }
+  }
+  if (!batch.empty()) {
+    result.add(batch);
+  }
+  co_return result;
+}
+Result run_tasks(std::size_t n, std::size_t limit) {
+  return coro::sync_wait(consume_tasks(n, limit));
+}
+
+template <typename T>
+void release(std::vector<T>& v) {
+  std::vector<T>{}.swap(v);
+}
+Result run_vector(std::size_t n, std::size_t limit) {
+  std::vector<Record> all(n);
+  std::uint64_t state = 88172645463325252ull;
+  for (auto& record : all) {
+    record = make_record(state);
+  }
+  std::vector<Record> kept;
+  std::copy_if(all.begin(), all.end(), std::back_inserter(kept), keep);
+  release(all);
+  std::vector<std::uint64_t> weights(kept.size());
+  std::transform(kept.begin(), kept.end(), weights.begin(), weigh);
+  release(kept);
+  weights.resize(std::min(weights.size(), limit));
+  std::vector<std::vector<std::uint64_t>> batches;
+  for (std::size_t i = 0; i < weights.size(); i += kBatch) {
+    auto last = std::min(weights.size(), i + kBatch);
+    batches.emplace_back(weights.begin() + i, weights.begin() + last);
+  }
+  release(weights);
+  Result result;
+  for (auto& batch : batches) {
+    result.add(batch);
+  }
+  return result;
+}
+
+void run(const char* name,
+         Result (*variant)(std::size_t, std::size_t),
+         std::size_t n,
+         std::size_t limit) {
+  std::fflush(stdout);
+  auto pid = ::fork();
+  if (pid == 0) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = variant(n, limit);
+    auto secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    auto frames = coro::frame_pool::local_stats().allocations;
+    std::printf("  %-16s %8.3f s  %7.2f ns/record  %6.1f Mrecords/s  "
+                "%10llu frames  checksum %016llx/%llu/%llu\n",
+                name, secs, secs * 1e9 / n, n / secs / 1e6,
+                static_cast<unsigned long long>(frames),
+                static_cast<unsigned long long>(result.sum),
+                static_cast<unsigned long long>(result.count),
+                static_cast<unsigned long long>(result.batches));
+    std::fflush(stdout);
+    ::_exit(0);
+  }
+  int status = 0;
+  ::rusage usage{};
+  ::wait4(pid, &status, 0, &usage);
+  if (WIFSIGNALED(status)) {
+    std::printf("  %-16s killed by signal %d\n", name, WTERMSIG(status));
+  }
+  std::printf("  %-16s peak RSS %.1f MiB\n", name, usage.ru_maxrss / 1024.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000'000;
+  // take() stops the lazy pipelines before the end of the source
+  auto limit = n / 2;
+  std::printf("%zu records, filter | transform | take(%zu) | batch(%zu)\n",
+              n, limit, kBatch);
+  run("generator", run_generator, n, limit);
+  run("async_generator", run_async_generator, n, limit);
+  run("task per record", run_tasks, n, limit);
+  run("vector", run_vector, n, limit);
+  return 0;
+}
@@ -0,0 +1,204 @@
+#ifndef CPPCORO_ASYNC_GENERATOR_HPP_
+#define CPPCORO_ASYNC_GENERATOR_HPP_
+
+#include <coroutine>
+#include <cppcoro/frame_pool.hpp>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+template <typename T>
+class async_generator;
+
+namespace detail {
+
+// producer and consumer take turns by symmetric transfer: co_await ++it
+// jumps into the producer, co_yield jumps back into whoever awaited last.
+// the producer may co_await anything meanwhile and come back on another
+// thread, it yields from there
+template <typename T>
+class async_generator_promise final : public pooled_frame {
+  struct yield_operation {
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<async_generator_promise> producer) noexcept {
+      return producer.promise().consumer_;
+    }
+    void await_resume() noexcept {}
+  };
+
+ public:
+  using value_type = std::remove_reference_t<T>;
+  using reference = std::conditional_t<std::is_reference_v<T>, T, T&>;
+  using pointer = value_type*;
+
+  async_generator_promise() noexcept = default;
+
+  async_generator<T> get_return_object() noexcept;
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  // no value left: the consumer sees the end
+  yield_operation final_suspend() noexcept {
+    value_ = nullptr;
+    return {};
+  }
+
+  yield_operation yield_value(value_type& value) noexcept {
+    value_ = std::addressof(value);
+    return {};
+  }
+  yield_operation yield_value(value_type&& value) noexcept {
+    value_ = std::addressof(value);
+    return {};
+  }
+  void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+  void return_void() noexcept {}
+
+  void set_consumer(std::coroutine_handle<> consumer) noexcept {
+    consumer_ = consumer;
+  }
+  bool finished() const noexcept { return value_ == nullptr; }
+  reference value() const noexcept { return static_cast<reference>(*value_); }
+  void rethrow_if_exception() {
+    if (exception_) {
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+  }
+
+ private:
+  std::coroutine_handle<> consumer_;
+  pointer value_ = nullptr;
+  std::exception_ptr exception_;
+};
+
+}  // namespace detail
+
+// @brief a lazy sequence produced by co_yield, whose body may co_await:
+// begin() and ++ are awaited
+//
+//   for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+//
+// the iterator refers to the yielded object in the producer's frame, as
+// with generator. an exception escaping the body is rethrown from the
+// co_await of begin() or ++
+template <typename T>
+class [[nodiscard]] async_generator {
+ public:
+  using promise_type = detail::async_generator_promise<T>;
+  using value_type = std::remove_cvref_t<T>;
+  using reference = typename promise_type::reference;
+  using pointer = typename promise_type::pointer;
+
+  class iterator;
+
+ private:
+  // resumes the producer up to its next co_yield or its end
+  struct advance_operation {
+    std::coroutine_handle<promise_type> producer;
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> consumer) noexcept {
+      producer.promise().set_consumer(consumer);
+      return producer;
+    }
+  };
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = async_generator::value_type;
+    using reference = async_generator::reference;
+    using pointer = async_generator::pointer;
+
+    iterator() noexcept = default;
+    explicit iterator(std::coroutine_handle<promise_type> coro) noexcept
+        : coro_{coro} {}
+
+    friend bool operator==(const iterator& it,
+                           std::default_sentinel_t) noexcept {
+      return !it.coro_;
+    }
+
+    auto operator++() noexcept {
+      struct increment_operation : advance_operation {
+        iterator& it;
+        iterator& await_resume() {
+          if (this->producer.promise().finished()) {
+            it.coro_ = nullptr;
+            this->producer.promise().rethrow_if_exception();
+          }
+          return it;
+        }
+      };
+      return increment_operation{{coro_}, *this};
+    }
+
+    reference operator*() const noexcept { return coro_.promise().value(); }
+    pointer operator->() const noexcept { return std::addressof(**this); }
+
+   private:
+    // null at the end
+    std::coroutine_handle<promise_type> coro_ = nullptr;
+  };
+
+  async_generator() noexcept = default;
+  explicit async_generator(std::coroutine_handle<promise_type> h) noexcept
+      : coro_{h} {}
+  async_generator(async_generator&& other) noexcept
+      : coro_{std::exchange(other.coro_, nullptr)} {}
+  async_generator& operator=(async_generator&& other) noexcept {
+    if (std::addressof(other) != this) {
+      if (coro_) {
+        coro_.destroy();
+      }
+      coro_ = std::exchange(other.coro_, nullptr);
+    }
+    return *this;
+  }
+  async_generator(const async_generator&) = delete;
+  async_generator& operator=(const async_generator&) = delete;
+  ~async_generator() {
+    if (coro_) {
+      coro_.destroy();
+    }
+  }
+
+  auto begin() noexcept {
+    struct begin_operation : advance_operation {
+      bool await_ready() const noexcept { return !this->producer; }
+      iterator await_resume() {
+        if (!this->producer) {
+          return iterator{};
+        }
+        if (this->producer.promise().finished()) {
+          this->producer.promise().rethrow_if_exception();
+          return iterator{};
+        }
+        return iterator{this->producer};
+      }
+    };
+    return begin_operation{{coro_}};
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+ private:
+  std::coroutine_handle<promise_type> coro_ = nullptr;
+};
+
+namespace detail {
+template <typename T>
+async_generator<T> async_generator_promise<T>::get_return_object() noexcept {
+  return async_generator<T>{
+      std::coroutine_handle<async_generator_promise>::from_promise(*this)};
+}
+}  // namespace detail
+
+}  // namespace coro
+
+#endif  // CPPCORO_ASYNC_GENERATOR_HPP_
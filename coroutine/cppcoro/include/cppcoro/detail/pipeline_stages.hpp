@@ -0,0 +1,244 @@
+#ifndef CPPCORO_DETAIL_PIPELINE_STAGES_HPP_
+#define CPPCORO_DETAIL_PIPELINE_STAGES_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coro {
+namespace detail {
+
+// a stage sees the records of its upstream one at a time: push() returns
+// the record it passes on, or nullptr to drop it, valid until the next
+// push(). exhausted() stops pulling the upstream, flush() hands out what
+// the stage held back once the upstream ended
+
+template <typename In, typename F>
+class transform_stage {
+  using result = std::invoke_result_t<F&, In&>;
+
+ public:
+  using input = In;
+  using output = std::remove_reference_t<result>;
+
+  explicit transform_stage(F f) : f_{std::move(f)} {}
+
+  output* push(In& in) {
+    if constexpr (std::is_lvalue_reference_v<result>) {
+      return std::addressof(std::invoke(f_, in));
+    } else {
+      return std::addressof(current_.emplace(std::invoke(f_, in)));
+    }
+  }
+  bool exhausted() const noexcept { return false; }
+  output* flush() noexcept { return nullptr; }
+
+ private:
+  F f_;
+  // the value computed from the last record
+  std::optional<std::remove_const_t<output>> current_;
+};
+
+template <typename In, typename Predicate>
+class filter_stage {
+ public:
+  using input = In;
+  using output = In;
+
+  explicit filter_stage(Predicate predicate)
+      : predicate_{std::move(predicate)} {}
+
+  output* push(In& in) {
+    return std::invoke(predicate_, std::as_const(in)) ? std::addressof(in)
+                                                      : nullptr;
+  }
+  bool exhausted() const noexcept { return false; }
+  output* flush() noexcept { return nullptr; }
+
+ private:
+  Predicate predicate_;
+};
+
+template <typename In>
+class take_stage {
+ public:
+  using input = In;
+  using output = In;
+
+  explicit take_stage(std::size_t count) noexcept : left_{count} {}
+
+  output* push(In& in) noexcept {
+    if (left_ == 0) {
+      return nullptr;
+    }
+    --left_;
+    return std::addressof(in);
+  }
+  bool exhausted() const noexcept { return left_ == 0; }
+  output* flush() noexcept { return nullptr; }
+
+ private:
+  std::size_t left_;
+};
+
+// the records are copied into one buffer, handed out by reference once full
+// and refilled from the next record on: its capacity is reused
+template <typename In>
+class batch_stage {
+ public:
+  using input = In;
+  using output = std::vector<std::remove_cv_t<In>>;
+
+  explicit batch_stage(std::size_t size) : size_{size == 0 ? 1 : size} {
+    batch_.reserve(size_);
+  }
+
+  output* push(In& in) {
+    if (handed_out_) {
+      // the consumer may have moved the batch away
+      batch_.clear();
+      batch_.reserve(size_);
+      handed_out_ = false;
+    }
+    batch_.push_back(in);
+    if (batch_.size() < size_) {
+      return nullptr;
+    }
+    handed_out_ = true;
+    return &batch_;
+  }
+  bool exhausted() const noexcept { return false; }
+  // the last, partial batch
+  output* flush() noexcept {
+    if (handed_out_ || batch_.empty()) {
+      return nullptr;
+    }
+    handed_out_ = true;
+    return &batch_;
+  }
+
+ private:
+  std::size_t size_;
+  output batch_;
+  bool handed_out_ = false;
+};
+
+// @brief the stages of a pipeline, run one after the other on every record
+// in the one frame or loop which pulls the source
+template <typename... Stages>
+class stage_chain {
+  using stages = std::tuple<Stages...>;
+
+ public:
+  using input = typename std::tuple_element_t<0, stages>::input;
+  using output =
+      typename std::tuple_element_t<sizeof...(Stages) - 1, stages>::output;
+  static constexpr std::size_t kStages = sizeof...(Stages);
+
+  explicit stage_chain(stages s) : stages_{std::move(s)} {}
+
+  // what comes out of the last stage, nullptr if a stage dropped it
+  output* push(input& in) { return push_from<0>(in); }
+
+  // a stage takes no more records: stop pulling the source
+  bool exhausted() const noexcept {
+    return std::apply([](const auto&... s) { return (s.exhausted() || ...); },
+                      stages_);
+  }
+
+  // once the source ended: what stage index still held back, through the
+  // stages after it. call it for every index in turn
+  output* flush(std::size_t index) {
+    return flush_at(index, std::index_sequence_for<Stages...>{});
+  }
+
+  template <typename Adaptor>
+  auto then(Adaptor adaptor) && {
+    auto next = std::move(adaptor).template bind<output>();
+    return stage_chain<Stages..., decltype(next)>{
+        std::tuple_cat(std::move(stages_), std::tuple{std::move(next)})};
+  }
+
+ private:
+  template <std::size_t I, typename In>
+  output* push_from(In& in) {
+    if constexpr (I == kStages) {
+      return std::addressof(in);
+    } else {
+      auto out = std::get<I>(stages_).push(in);
+      return out != nullptr ? push_from<I + 1>(*out) : nullptr;
+    }
+  }
+  template <std::size_t I>
+  output* flush_stage() {
+    auto out = std::get<I>(stages_).flush();
+    return out != nullptr ? push_from<I + 1>(*out) : nullptr;
+  }
+  template <std::size_t... I>
+  output* flush_at(std::size_t index, std::index_sequence<I...>) {
+    output* out = nullptr;
+    ((index == I ? (out = flush_stage<I>(), true) : false) || ...);
+    return out;
+  }
+
+  stages stages_;
+};
+
+// the first stage of a chain over records of type In
+template <typename In, typename Adaptor>
+auto make_stage_chain(Adaptor adaptor) {
+  auto first = std::move(adaptor).template bind<In>();
+  return stage_chain<decltype(first)>{std::tuple{std::move(first)}};
+}
+
+// base of transform(), filter(), take() and batch(), whose bind<In>()
+// makes their stage for records of type In
+struct pipeline_adaptor {};
+
+template <typename T>
+inline constexpr bool is_pipeline_adaptor_v =
+    std::is_base_of_v<pipeline_adaptor, T>;
+
+template <typename F>
+struct transform_adaptor : pipeline_adaptor {
+  F f;
+  template <typename In>
+  transform_stage<In, F> bind() && {
+    return transform_stage<In, F>{std::move(f)};
+  }
+};
+
+template <typename Predicate>
+struct filter_adaptor : pipeline_adaptor {
+  Predicate predicate;
+  template <typename In>
+  filter_stage<In, Predicate> bind() && {
+    return filter_stage<In, Predicate>{std::move(predicate)};
+  }
+};
+
+struct take_adaptor : pipeline_adaptor {
+  std::size_t count;
+  template <typename In>
+  take_stage<In> bind() && {
+    return take_stage<In>{count};
+  }
+};
+
+struct batch_adaptor : pipeline_adaptor {
+  std::size_t size;
+  template <typename In>
+  batch_stage<In> bind() && {
+    return batch_stage<In>{size};
+  }
+};
+
+}  // namespace detail
+}  // namespace coro
+
+#endif  // CPPCORO_DETAIL_PIPELINE_STAGES_HPP_
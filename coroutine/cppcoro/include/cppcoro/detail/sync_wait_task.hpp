@@ -0,0 +1,186 @@
+#ifndef CPPCORO_DETAIL_SYNC_WAIT_TASK_HPP_
+#define CPPCORO_DETAIL_SYNC_WAIT_TASK_HPP_
+
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cppcoro/traits/await_traits.hpp>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+namespace detail {
+
+// @brief set once by the thread which completes the awaitable. set() only
+// touches the event under the lock, so the waiter may destroy it as soon as
+// wait() returned
+class sync_wait_event {
+ public:
+  void set() noexcept {
+    std::unique_lock lock{mutex_};
+    set_ = true;
+    cv_.notify_one();
+  }
+  void wait() noexcept {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return set_; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool set_ = false;
+};
+
+template <typename Result>
+class sync_wait_task;
+
+template <typename Result>
+class sync_wait_task_promise {
+  struct completion_notifier {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(
+        std::coroutine_handle<sync_wait_task_promise> coro) const noexcept {
+      coro.promise().event_->set();
+    }
+    void await_resume() noexcept {}
+  };
+
+ public:
+  using reference = Result&&;
+
+  sync_wait_task_promise() noexcept = default;
+
+  void start(sync_wait_event& event) {
+    event_ = &event;
+    std::coroutine_handle<sync_wait_task_promise>::from_promise(*this)
+        .resume();
+  }
+
+  sync_wait_task<Result> get_return_object() noexcept;
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  completion_notifier final_suspend() noexcept { return {}; }
+
+  // co_yield co_await awaitable: the result stays in the frame suspended
+  // here, only its address is kept and nothing is copied
+  completion_notifier yield_value(reference result) noexcept {
+    result_ = std::addressof(result);
+    return final_suspend();
+  }
+  void return_void() noexcept {
+    // the coroutine always suspends at co_yield
+    assert(false);
+  }
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  reference result() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+    return static_cast<reference>(*result_);
+  }
+
+ private:
+  sync_wait_event* event_ = nullptr;
+  std::remove_reference_t<Result>* result_ = nullptr;
+  std::exception_ptr exception_;
+};
+
+template <>
+class sync_wait_task_promise<void> {
+  struct completion_notifier {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(
+        std::coroutine_handle<sync_wait_task_promise> coro) const noexcept {
+      coro.promise().event_->set();
+    }
+    void await_resume() noexcept {}
+  };
+
+ public:
+  sync_wait_task_promise() noexcept = default;
+
+  void start(sync_wait_event& event) {
+    event_ = &event;
+    std::coroutine_handle<sync_wait_task_promise>::from_promise(*this)
+        .resume();
+  }
+
+  sync_wait_task<void> get_return_object() noexcept;
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  completion_notifier final_suspend() noexcept { return {}; }
+
+  void return_void() noexcept {}
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  void result() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  sync_wait_event* event_ = nullptr;
+  std::exception_ptr exception_;
+};
+
+// @brief the coroutine sync_wait() runs the awaitable in
+template <typename Result>
+class sync_wait_task final {
+ public:
+  using promise_type = sync_wait_task_promise<Result>;
+
+  explicit sync_wait_task(std::coroutine_handle<promise_type> h) noexcept
+      : coro_{h} {}
+  sync_wait_task(sync_wait_task&& other) noexcept
+      : coro_{std::exchange(other.coro_, nullptr)} {}
+  sync_wait_task(const sync_wait_task&) = delete;
+  sync_wait_task& operator=(const sync_wait_task&) = delete;
+  ~sync_wait_task() {
+    if (coro_) {
+      coro_.destroy();
+    }
+  }
+
+  void start(sync_wait_event& event) { coro_.promise().start(event); }
+  decltype(auto) result() { return coro_.promise().result(); }
+
+ private:
+  std::coroutine_handle<promise_type> coro_;
+};
+
+template <typename Result>
+sync_wait_task<Result>
+sync_wait_task_promise<Result>::get_return_object() noexcept {
+  return sync_wait_task<Result>{
+      std::coroutine_handle<sync_wait_task_promise>::from_promise(*this)};
+}
+inline sync_wait_task<void>
+sync_wait_task_promise<void>::get_return_object() noexcept {
+  return sync_wait_task<void>{
+      std::coroutine_handle<sync_wait_task_promise>::from_promise(*this)};
+}
+
+template <typename Awaitable,
+          typename Result =
+              typename awaitable_traits<Awaitable&&>::await_result_t,
+          std::enable_if_t<!std::is_void_v<Result>, int> = 0>
+sync_wait_task<Result> make_sync_wait_task(Awaitable&& awaitable) {
+  co_yield co_await std::forward<Awaitable>(awaitable);
+}
+
+template <typename Awaitable,
+          typename Result =
+              typename awaitable_traits<Awaitable&&>::await_result_t,
+          std::enable_if_t<std::is_void_v<Result>, int> = 0>
+sync_wait_task<void> make_sync_wait_task(Awaitable&& awaitable) {
+  co_await std::forward<Awaitable>(awaitable);
+}
+
+}  // namespace detail
+}  // namespace coro
+
+#endif  // CPPCORO_DETAIL_SYNC_WAIT_TASK_HPP_
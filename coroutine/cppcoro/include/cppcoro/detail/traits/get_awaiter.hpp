@@ -37,7 +37,7 @@ auto get_awaiter_impl(T&& t, coro::detail::any) noexcept {
 template <typename T>
 auto get_awaiter(T&& value) noexcept(
     noexcept(detail::get_awaiter_impl(std::forward<T>(value), 123)))
-    -> decltye(detail::get_awaiter_impl(std::forward<T>(value), 123)) {
+    -> decltype(detail::get_awaiter_impl(std::forward<T>(value), 123)) {
   return detail::get_awaiter_impl(std::forward<T>(value), 123);
 }
 
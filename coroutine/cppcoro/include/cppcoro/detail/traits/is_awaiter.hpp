@@ -21,22 +21,19 @@ struct is_valid_await_suspend_return_value
                        std::is_same<T, bool>,
                        is_coroutine_handle<T>> {};
 
+// false for a type without the awaiter interface, instead of an error in
+// the decltype of the checks below
 template <typename T, typename = std::void_t<>>
-struct has_awaiter_interface : std::false_type {};
+struct is_awaiter : std::false_type {};
 
 template <typename T>
-struct has_awaiter_interface<
+struct is_awaiter<
     T,
     std::void_t<decltype(std::declval<T>().await_ready()),
                 decltype(std::declval<T>().await_suspend(
                     std::declval<std::coroutine_handle<void>>())),
-                decltype(std::declval<T>().await_resume())>> : std::true_type {
-};
-
-template <typename T>
-struct is_awaiter
+                decltype(std::declval<T>().await_resume())>>
     : std::conjunction<
-          detail::has_awaiter_interface<T>,
           std::is_constructible<bool,
                                 decltype(std::declval<T>().await_ready())>,
           detail::is_valid_await_suspend_return_value<
@@ -3,17 +3,17 @@
 
 namespace coro {
 template <typename T>
-struct remove_rvalue_referenc {
+struct remove_rvalue_reference {
   using type = T;
 };
 
 template <typename T>
-struct remove_rvalue_referenc<T&&> {
+struct remove_rvalue_reference<T&&> {
   using type = T;
 };
 
 template <typename T>
-using remove_rvalue_referenc_t = typename remove_rvalue_referenc<T>::value;
+using remove_rvalue_reference_t = typename remove_rvalue_reference<T>::type;
 }  // namespace coro
 
 #endif  // CPPCORO_DETAIL_TRAITS_REMOVE_RVALUE_REFERENCE_HPP_
@@ -0,0 +1,12 @@
+#ifndef CPPCORO_DETAIL_VOID_VALUE_HPP_
+#define CPPCORO_DETAIL_VOID_VALUE_HPP_
+
+namespace coro {
+namespace detail {
+// @brief the result of a void awaitable in the tuple of when_all()
+struct void_value {};
+
+}  // namespace detail
+}  // namespace coro
+
+#endif  // CPPCORO_DETAIL_VOID_VALUE_HPP_
@@ -0,0 +1,41 @@
+#ifndef CPPCORO_DETAIL_WHEN_ALL_COUNTER_HPP_
+#define CPPCORO_DETAIL_WHEN_ALL_COUNTER_HPP_
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+
+namespace coro {
+namespace detail {
+
+// @brief the children still running, plus one for the awaiting coroutine
+// until it suspended: whichever of the last child and the awaiter comes
+// last resumes the awaiter, the children may complete on any thread
+class when_all_counter {
+ public:
+  explicit when_all_counter(std::size_t count) noexcept : count_{count + 1} {}
+
+  // already awaited and completed
+  bool is_ready() const noexcept { return static_cast<bool>(awaiting_); }
+
+  // false if all the children completed meanwhile, the awaiter goes on
+  bool try_await(std::coroutine_handle<> awaiting) noexcept {
+    awaiting_ = awaiting;
+    return count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+  }
+
+  void notify_awaitable_completed() noexcept {
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      awaiting_.resume();
+    }
+  }
+
+ private:
+  std::atomic<std::size_t> count_;
+  std::coroutine_handle<> awaiting_;
+};
+
+}  // namespace detail
+}  // namespace coro
+
+#endif  // CPPCORO_DETAIL_WHEN_ALL_COUNTER_HPP_
@@ -0,0 +1,122 @@
+#ifndef CPPCORO_DETAIL_WHEN_ALL_READY_AWAITABLE_HPP_
+#define CPPCORO_DETAIL_WHEN_ALL_READY_AWAITABLE_HPP_
+
+#include <coroutine>
+#include <cppcoro/detail/when_all_counter.hpp>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace coro {
+namespace detail {
+
+template <typename Tasks>
+class when_all_ready_awaitable;
+
+// @brief starts every child in turn on the awaiting thread: a child which
+// suspends, e.g. on co_await pool.schedule(), lets the next one start and
+// the children run concurrently. the awaiter is resumed by the last child
+// to complete, on whatever thread that is
+template <typename... Tasks>
+class when_all_ready_awaitable<std::tuple<Tasks...>> {
+ public:
+  explicit when_all_ready_awaitable(Tasks&&... tasks) noexcept
+      : counter_{sizeof...(Tasks)}, tasks_{std::move(tasks)...} {}
+  when_all_ready_awaitable(when_all_ready_awaitable&& other) noexcept
+      : counter_{sizeof...(Tasks)}, tasks_{std::move(other.tasks_)} {}
+  when_all_ready_awaitable(const when_all_ready_awaitable&) = delete;
+  when_all_ready_awaitable& operator=(const when_all_ready_awaitable&) =
+      delete;
+
+  auto operator co_await() & noexcept {
+    struct awaiter {
+      when_all_ready_awaitable& awaitable;
+      bool await_ready() const noexcept { return awaitable.is_ready(); }
+      bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        return awaitable.try_await(awaiting);
+      }
+      std::tuple<Tasks...>& await_resume() noexcept {
+        return awaitable.tasks_;
+      }
+    };
+    return awaiter{*this};
+  }
+  auto operator co_await() && noexcept {
+    struct awaiter {
+      when_all_ready_awaitable& awaitable;
+      bool await_ready() const noexcept { return awaitable.is_ready(); }
+      bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        return awaitable.try_await(awaiting);
+      }
+      std::tuple<Tasks...>&& await_resume() noexcept {
+        return std::move(awaitable.tasks_);
+      }
+    };
+    return awaiter{*this};
+  }
+
+ private:
+  bool is_ready() const noexcept { return counter_.is_ready(); }
+  bool try_await(std::coroutine_handle<> awaiting) noexcept {
+    std::apply([this](auto&... tasks) { (tasks.start(counter_), ...); },
+               tasks_);
+    return counter_.try_await(awaiting);
+  }
+
+  when_all_counter counter_;
+  std::tuple<Tasks...> tasks_;
+};
+
+template <typename Task>
+class when_all_ready_awaitable<std::vector<Task>> {
+ public:
+  explicit when_all_ready_awaitable(std::vector<Task>&& tasks) noexcept
+      : counter_{tasks.size()}, tasks_{std::move(tasks)} {}
+  when_all_ready_awaitable(when_all_ready_awaitable&& other) noexcept
+      : counter_{other.tasks_.size()}, tasks_{std::move(other.tasks_)} {}
+  when_all_ready_awaitable(const when_all_ready_awaitable&) = delete;
+  when_all_ready_awaitable& operator=(const when_all_ready_awaitable&) =
+      delete;
+
+  auto operator co_await() & noexcept {
+    struct awaiter {
+      when_all_ready_awaitable& awaitable;
+      bool await_ready() const noexcept { return awaitable.is_ready(); }
+      bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        return awaitable.try_await(awaiting);
+      }
+      std::vector<Task>& await_resume() noexcept { return awaitable.tasks_; }
+    };
+    return awaiter{*this};
+  }
+  auto operator co_await() && noexcept {
+    struct awaiter {
+      when_all_ready_awaitable& awaitable;
+      bool await_ready() const noexcept { return awaitable.is_ready(); }
+      bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        return awaitable.try_await(awaiting);
+      }
+      std::vector<Task>&& await_resume() noexcept {
+        return std::move(awaitable.tasks_);
+      }
+    };
+    return awaiter{*this};
+  }
+
+ private:
+  bool is_ready() const noexcept { return counter_.is_ready(); }
+  bool try_await(std::coroutine_handle<> awaiting) noexcept {
+    for (auto& task : tasks_) {
+      task.start(counter_);
+    }
+    return counter_.try_await(awaiting);
+  }
+
+  when_all_counter counter_;
+  std::vector<Task> tasks_;
+};
+
+}  // namespace detail
+}  // namespace coro
+
+#endif  // CPPCORO_DETAIL_WHEN_ALL_READY_AWAITABLE_HPP_
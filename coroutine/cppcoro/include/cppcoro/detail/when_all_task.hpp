@@ -0,0 +1,195 @@
+#ifndef CPPCORO_DETAIL_WHEN_ALL_TASK_HPP_
+#define CPPCORO_DETAIL_WHEN_ALL_TASK_HPP_
+
+#include <cassert>
+#include <coroutine>
+#include <cppcoro/detail/void_value.hpp>
+#include <cppcoro/detail/when_all_counter.hpp>
+#include <cppcoro/frame_pool.hpp>
+#include <cppcoro/traits/await_traits.hpp>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+namespace detail {
+
+template <typename Result>
+class when_all_task;
+
+// the final suspend point reports to the counter: the child frame stays
+// alive, with its result, until the when_all_task is destroyed
+template <typename Result>
+class when_all_task_promise final : public pooled_frame {
+  struct completion_notifier {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(
+        std::coroutine_handle<when_all_task_promise> coro) const noexcept {
+      coro.promise().counter_->notify_awaitable_completed();
+    }
+    void await_resume() const noexcept {}
+  };
+
+ public:
+  using reference = Result&&;
+
+  when_all_task_promise() noexcept = default;
+
+  when_all_task<Result> get_return_object() noexcept;
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  completion_notifier final_suspend() noexcept { return {}; }
+
+  // co_yield co_await awaitable: the result stays in the suspended frame
+  completion_notifier yield_value(reference result) noexcept {
+    result_ = std::addressof(result);
+    return final_suspend();
+  }
+  void return_void() noexcept {
+    // the coroutine always suspends at co_yield
+    assert(false);
+  }
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+
+  void start(when_all_counter& counter) noexcept {
+    counter_ = &counter;
+    std::coroutine_handle<when_all_task_promise>::from_promise(*this)
+        .resume();
+  }
+
+  Result& result() & {
+    rethrow_if_exception();
+    return *result_;
+  }
+  reference result() && {
+    rethrow_if_exception();
+    return std::forward<Result>(*result_);
+  }
+
+ private:
+  void rethrow_if_exception() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+  when_all_counter* counter_ = nullptr;
+  std::exception_ptr exception_;
+  std::add_pointer_t<Result> result_ = nullptr;
+};
+
+template <>
+class when_all_task_promise<void> final : public pooled_frame {
+  struct completion_notifier {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(
+        std::coroutine_handle<when_all_task_promise> coro) const noexcept {
+      coro.promise().counter_->notify_awaitable_completed();
+    }
+    void await_resume() const noexcept {}
+  };
+
+ public:
+  when_all_task_promise() noexcept = default;
+
+  when_all_task<void> get_return_object() noexcept;
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  completion_notifier final_suspend() noexcept { return {}; }
+
+  void return_void() noexcept {}
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+
+  void start(when_all_counter& counter) noexcept {
+    counter_ = &counter;
+    std::coroutine_handle<when_all_task_promise>::from_promise(*this)
+        .resume();
+  }
+
+  void result() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  when_all_counter* counter_ = nullptr;
+  std::exception_ptr exception_;
+};
+
+// @brief one child of when_all_ready(): it runs the awaitable once started
+// and keeps its result (or exception) until it is destroyed
+template <typename Result>
+class when_all_task final {
+ public:
+  using promise_type = when_all_task_promise<Result>;
+
+  explicit when_all_task(std::coroutine_handle<promise_type> h) noexcept
+      : coro_{h} {}
+  when_all_task(when_all_task&& other) noexcept
+      : coro_{std::exchange(other.coro_, nullptr)} {}
+  when_all_task(const when_all_task&) = delete;
+  when_all_task& operator=(const when_all_task&) = delete;
+  ~when_all_task() {
+    if (coro_) {
+      coro_.destroy();
+    }
+  }
+
+  decltype(auto) result() & { return coro_.promise().result(); }
+  decltype(auto) result() && { return std::move(coro_.promise()).result(); }
+
+  // void_value for a void awaitable, so that when_all() has a tuple element
+  decltype(auto) non_void_result() && {
+    if constexpr (std::is_void_v<Result>) {
+      std::move(*this).result();
+      return void_value{};
+    } else {
+      return std::move(*this).result();
+    }
+  }
+
+  void start(when_all_counter& counter) noexcept {
+    coro_.promise().start(counter);
+  }
+
+ private:
+  std::coroutine_handle<promise_type> coro_;
+};
+
+template <typename Result>
+when_all_task<Result>
+when_all_task_promise<Result>::get_return_object() noexcept {
+  return when_all_task<Result>{
+      std::coroutine_handle<when_all_task_promise>::from_promise(*this)};
+}
+inline when_all_task<void>
+when_all_task_promise<void>::get_return_object() noexcept {
+  return when_all_task<void>{
+      std::coroutine_handle<when_all_task_promise>::from_promise(*this)};
+}
+
+// the awaitable is moved into the child frame, which owns it
+template <typename Awaitable,
+          typename Result =
+              typename awaitable_traits<Awaitable&&>::await_result_t,
+          std::enable_if_t<!std::is_void_v<Result>, int> = 0>
+when_all_task<Result> make_when_all_task(Awaitable awaitable) {
+  co_yield co_await static_cast<Awaitable&&>(awaitable);
+}
+
+template <typename Awaitable,
+          typename Result =
+              typename awaitable_traits<Awaitable&&>::await_result_t,
+          std::enable_if_t<std::is_void_v<Result>, int> = 0>
+when_all_task<void> make_when_all_task(Awaitable awaitable) {
+  co_await static_cast<Awaitable&&>(awaitable);
+}
+
+}  // namespace detail
+}  // namespace coro
+
+#endif  // CPPCORO_DETAIL_WHEN_ALL_TASK_HPP_
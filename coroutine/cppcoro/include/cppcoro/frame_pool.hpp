@@ -0,0 +1,189 @@
+#ifndef CPPCORO_FRAME_POOL_HPP_
+#define CPPCORO_FRAME_POOL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// only standard headers: the example schedulers include this file by path
+
+namespace coro {
+
+// @brief counters of the coroutine frames allocated through frame_pool
+struct frame_pool_stats {
+  static constexpr std::size_t kGranularity = 64;
+  static constexpr std::size_t kClasses = 16;
+
+  std::uint64_t allocations = 0;
+  // served from a free list instead of operator new
+  std::uint64_t hits = 0;
+  // larger than the biggest size class
+  std::uint64_t oversized = 0;
+  // allocations per size class, sizes[i] counts the frames of up to
+  // (i + 1) * kGranularity bytes
+  std::array<std::uint64_t, kClasses> sizes{};
+
+  double hit_rate() const noexcept {
+    return allocations == 0 ? 0.0 : static_cast<double>(hits) / allocations;
+  }
+};
+
+// @brief thread-local size-class free lists for coroutine frames
+//
+// a frame of up to kClasses * kGranularity bytes is rounded up to its class
+// and, once freed, kept on a free list of the freeing thread for the next
+// frame of that class: short-lived coroutines stop going to malloc. a frame
+// may be freed on another thread than the one which allocated it, as with
+// a work-stealing scheduler, it then simply moves to that thread's list.
+// every list keeps at most kMaxCached frames, the rest goes back to
+// operator delete.
+//
+// with CPPCORO_NO_FRAME_POOL defined every frame goes to operator new, the
+// counters still count, to compare both
+class frame_pool {
+ public:
+  static constexpr std::size_t kGranularity = frame_pool_stats::kGranularity;
+  static constexpr std::size_t kClasses = frame_pool_stats::kClasses;
+  static constexpr std::size_t kMaxCached = 256;
+
+  static void* allocate(std::size_t size) {
+    auto cls = size_class(size);
+    auto& pool = local();
+    pool.bump(pool.allocations_);
+    if (cls == kClasses) {
+      pool.bump(pool.oversized_);
+      return ::operator new(size);
+    }
+    pool.bump(pool.sizes_[cls]);
+#ifndef CPPCORO_NO_FRAME_POOL
+    if (auto block = pool.free_[cls]) {
+      pool.free_[cls] = block->next;
+      --pool.cached_[cls];
+      pool.bump(pool.hits_);
+      return block;
+    }
+#endif
+    return ::operator new(class_size(cls));
+  }
+
+  static void deallocate(void* frame, std::size_t size) noexcept {
+    auto cls = size_class(size);
+    if (cls == kClasses) {
+      ::operator delete(frame, size);
+      return;
+    }
+#ifndef CPPCORO_NO_FRAME_POOL
+    // a frame destroyed by a thread_local or a static destructor after the
+    // pool of its thread is gone
+    if (!destroyed_) {
+      auto& pool = local();
+      if (pool.cached_[cls] < kMaxCached) {
+        pool.free_[cls] = new (frame) free_block{pool.free_[cls]};
+        ++pool.cached_[cls];
+        return;
+      }
+    }
+#endif
+    ::operator delete(frame, class_size(cls));
+  }
+
+  // @brief the counters of all the threads, those exited included
+  static frame_pool_stats stats() {
+    std::unique_lock lock{registry_mutex_};
+    auto total = retired_;
+    for (auto pool : pools_) {
+      pool->add_to(total);
+    }
+    return total;
+  }
+
+  // @brief the counters of the calling thread
+  static frame_pool_stats local_stats() {
+    frame_pool_stats stats;
+    local().add_to(stats);
+    return stats;
+  }
+
+  frame_pool(const frame_pool&) = delete;
+  frame_pool& operator=(const frame_pool&) = delete;
+
+ private:
+  struct free_block {
+    free_block* next;
+  };
+  using counter = std::atomic<std::uint64_t>;
+
+  frame_pool() {
+    std::unique_lock lock{registry_mutex_};
+    pools_.push_back(this);
+  }
+  ~frame_pool() {
+    destroyed_ = true;
+    for (std::size_t cls = 0; cls < kClasses; ++cls) {
+      while (auto block = free_[cls]) {
+        free_[cls] = block->next;
+        ::operator delete(block, class_size(cls));
+      }
+    }
+    std::unique_lock lock{registry_mutex_};
+    add_to(retired_);
+    pools_.erase(std::find(pools_.begin(), pools_.end(), this));
+  }
+
+  static frame_pool& local() {
+    thread_local frame_pool pool;
+    return pool;
+  }
+  static constexpr std::size_t size_class(std::size_t size) noexcept {
+    return size == 0 ? 0
+                     : std::min((size - 1) / kGranularity, kClasses);
+  }
+  static constexpr std::size_t class_size(std::size_t cls) noexcept {
+    return (cls + 1) * kGranularity;
+  }
+
+  // the owner only writes, stats() reads from any thread: no locked RMW
+  static void bump(counter& value) noexcept {
+    value.store(value.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  }
+  void add_to(frame_pool_stats& stats) const noexcept {
+    stats.allocations += allocations_.load(std::memory_order_relaxed);
+    stats.hits += hits_.load(std::memory_order_relaxed);
+    stats.oversized += oversized_.load(std::memory_order_relaxed);
+    for (std::size_t cls = 0; cls < kClasses; ++cls) {
+      stats.sizes[cls] += sizes_[cls].load(std::memory_order_relaxed);
+    }
+  }
+
+  std::array<free_block*, kClasses> free_{};
+  std::array<std::size_t, kClasses> cached_{};
+  counter allocations_{0};
+  counter hits_{0};
+  counter oversized_{0};
+  std::array<counter, kClasses> sizes_{};
+
+  static inline thread_local bool destroyed_ = false;
+  static inline std::mutex registry_mutex_;
+  static inline std::vector<frame_pool*> pools_;
+  static inline frame_pool_stats retired_;
+};
+
+// @brief base of a promise type whose coroutine frames come from frame_pool
+struct pooled_frame {
+  static void* operator new(std::size_t size) {
+    return frame_pool::allocate(size);
+  }
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    frame_pool::deallocate(frame, size);
+  }
+};
+
+}  // namespace coro
+
+#endif  // CPPCORO_FRAME_POOL_HPP_
@@ -0,0 +1,160 @@
+#ifndef CPPCORO_GENERATOR_HPP_
+#define CPPCORO_GENERATOR_HPP_
+
+#include <coroutine>
+#include <cppcoro/frame_pool.hpp>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+template <typename T>
+class generator;
+
+namespace detail {
+
+// the promise only keeps the address of the yielded value: it lives in the
+// suspended frame until the consumer moves on, nothing is copied
+template <typename T>
+class generator_promise final : public pooled_frame {
+ public:
+  using value_type = std::remove_reference_t<T>;
+  using reference = std::conditional_t<std::is_reference_v<T>, T, T&>;
+  using pointer = value_type*;
+
+  generator_promise() noexcept = default;
+
+  generator<T> get_return_object() noexcept;
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  std::suspend_always final_suspend() const noexcept { return {}; }
+
+  std::suspend_always yield_value(value_type& value) noexcept {
+    value_ = std::addressof(value);
+    return {};
+  }
+  // co_yield of a temporary: it lives until the generator is resumed
+  std::suspend_always yield_value(value_type&& value) noexcept {
+    value_ = std::addressof(value);
+    return {};
+  }
+  void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+  void return_void() noexcept {}
+
+  // nothing would resume a generator suspended on anything else than
+  // co_yield, async_generator allows co_await
+  template <typename U>
+  std::suspend_never await_transform(U&& value) = delete;
+
+  reference value() const noexcept { return static_cast<reference>(*value_); }
+  void rethrow_if_exception() {
+    if (exception_) {
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+  }
+
+ private:
+  pointer value_ = nullptr;
+  std::exception_ptr exception_;
+};
+
+}  // namespace detail
+
+// @brief a lazy sequence produced by co_yield, pulled on the calling thread
+//
+// the body runs up to the first co_yield on begin(), and to the next one
+// on every ++: the iterator refers to the yielded object itself, in the
+// generator's frame. an exception escaping the body is rethrown from
+// begin() or ++. single pass, the generator is move-only
+template <typename T>
+class [[nodiscard]] generator {
+ public:
+  using promise_type = detail::generator_promise<T>;
+  using value_type = std::remove_cvref_t<T>;
+  using reference = typename promise_type::reference;
+  using pointer = typename promise_type::pointer;
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = generator::value_type;
+    using reference = generator::reference;
+    using pointer = generator::pointer;
+
+    iterator() noexcept = default;
+    explicit iterator(std::coroutine_handle<promise_type> coro) noexcept
+        : coro_{coro} {}
+
+    friend bool operator==(const iterator& it,
+                           std::default_sentinel_t) noexcept {
+      return !it.coro_ || it.coro_.done();
+    }
+
+    iterator& operator++() {
+      coro_.resume();
+      if (coro_.done()) {
+        coro_.promise().rethrow_if_exception();
+      }
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    reference operator*() const noexcept { return coro_.promise().value(); }
+    pointer operator->() const noexcept { return std::addressof(**this); }
+
+   private:
+    std::coroutine_handle<promise_type> coro_ = nullptr;
+  };
+
+  generator() noexcept = default;
+  explicit generator(std::coroutine_handle<promise_type> h) noexcept
+      : coro_{h} {}
+  generator(generator&& other) noexcept
+      : coro_{std::exchange(other.coro_, nullptr)} {}
+  generator& operator=(generator&& other) noexcept {
+    if (std::addressof(other) != this) {
+      if (coro_) {
+        coro_.destroy();
+      }
+      coro_ = std::exchange(other.coro_, nullptr);
+    }
+    return *this;
+  }
+  generator(const generator&) = delete;
+  generator& operator=(const generator&) = delete;
+  ~generator() {
+    if (coro_) {
+      coro_.destroy();
+    }
+  }
+
+  iterator begin() {
+    if (coro_) {
+      coro_.resume();
+      if (coro_.done()) {
+        coro_.promise().rethrow_if_exception();
+      }
+    }
+    return iterator{coro_};
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+ private:
+  std::coroutine_handle<promise_type> coro_ = nullptr;
+};
+
+namespace detail {
+template <typename T>
+generator<T> generator_promise<T>::get_return_object() noexcept {
+  return generator<T>{
+      std::coroutine_handle<generator_promise>::from_promise(*this)};
+}
+}  // namespace detail
+
+}  // namespace coro
+
+#endif  // CPPCORO_GENERATOR_HPP_
@@ -0,0 +1,234 @@
+#ifndef CPPCORO_PIPELINE_HPP_
+#define CPPCORO_PIPELINE_HPP_
+
+#include <cassert>
+#include <cppcoro/async_generator.hpp>
+#include <cppcoro/detail/pipeline_stages.hpp>
+#include <cppcoro/generator.hpp>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+// @brief record-by-record stages over a generator or an async_generator:
+//
+//   for (auto& batch : records(fd) | filter(valid) | transform(parse) |
+//                      take(limit) | batch(1024))
+//
+// the stages of a pipeline are fused, they all run on a record before the
+// source is pulled again: over a generator, in the consumer's loop without
+// any frame of their own, over an async_generator, in one frame for the
+// whole chain. each stage hands the next one a reference, transform() keeps
+// its value until the next record, batch() copies the records into a
+// buffer it reuses. take() stops pulling the source after count records
+
+// @brief the result of f(record) for every record
+template <typename F>
+detail::transform_adaptor<std::decay_t<F>> transform(F&& f) {
+  return {{}, std::forward<F>(f)};
+}
+
+// @brief the records for which predicate(record) is true
+template <typename Predicate>
+detail::filter_adaptor<std::decay_t<Predicate>> filter(
+    Predicate&& predicate) {
+  return {{}, std::forward<Predicate>(predicate)};
+}
+
+// @brief the first count records
+inline detail::take_adaptor take(std::size_t count) noexcept {
+  return {{}, count};
+}
+
+// @brief std::vector of size records, the last one may be shorter
+inline detail::batch_adaptor batch(std::size_t size) noexcept {
+  return {{}, size};
+}
+
+namespace detail {
+
+// pulls the source in ++ until a record made it through the stages
+template <typename Source, typename Chain>
+class generator_pipe {
+  using output = typename Chain::output;
+
+ public:
+  using value_type = std::remove_cv_t<output>;
+  using reference = output&;
+  using pointer = output*;
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = generator_pipe::value_type;
+    using reference = generator_pipe::reference;
+    using pointer = generator_pipe::pointer;
+
+    iterator() noexcept = default;
+    explicit iterator(generator_pipe* pipe) noexcept : pipe_{pipe} {}
+
+    friend bool operator==(const iterator& it,
+                           std::default_sentinel_t) noexcept {
+      return it.at_end();
+    }
+
+    iterator& operator++() {
+      pipe_->current_ = pipe_->next();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    reference operator*() const noexcept { return *pipe_->current_; }
+    pointer operator->() const noexcept { return pipe_->current_; }
+
+   private:
+    bool at_end() const noexcept { return pipe_->current_ == nullptr; }
+
+    generator_pipe* pipe_ = nullptr;
+  };
+
+  generator_pipe(Source source, Chain chain)
+      : source_{std::move(source)}, chain_{std::move(chain)} {}
+
+  iterator begin() {
+    current_ = next();
+    return iterator{this};
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+  template <typename Adaptor,
+            std::enable_if_t<is_pipeline_adaptor_v<Adaptor>, int> = 0>
+  friend auto operator|(generator_pipe&& pipe, Adaptor adaptor) {
+    auto chain = std::move(pipe.chain_).then(std::move(adaptor));
+    return generator_pipe<Source, decltype(chain)>{std::move(pipe.source_),
+                                                   std::move(chain)};
+  }
+
+ private:
+  output* next() {
+    while (!draining_) {
+      if (chain_.exhausted()) {
+        draining_ = true;
+      } else {
+        if (started_) {
+          ++it_;
+        } else {
+          it_ = source_.begin();
+          started_ = true;
+        }
+        if (it_ == source_.end()) {
+          draining_ = true;
+        } else if (auto out = chain_.push(*it_)) {
+          return out;
+        }
+      }
+    }
+    while (flushed_ < Chain::kStages) {
+      if (auto out = chain_.flush(flushed_++)) {
+        return out;
+      }
+    }
+    return nullptr;
+  }
+
+  Source source_;
+  Chain chain_;
+  typename Source::iterator it_;
+  bool started_ = false;
+  // the source ended or the chain is exhausted
+  bool draining_ = false;
+  std::size_t flushed_ = 0;
+  output* current_ = nullptr;
+};
+
+// runs the stages in one async_generator frame, made on begin()
+template <typename Source, typename Chain>
+class async_generator_pipe {
+  using output = typename Chain::output;
+
+ public:
+  using generator_type = async_generator<output>;
+  using value_type = std::remove_cv_t<output>;
+  using reference = output&;
+
+  async_generator_pipe(Source source, Chain chain)
+      : source_{std::move(source)}, chain_{std::move(chain)} {}
+
+  // single pass: begin() once
+  auto begin() {
+    assert(!started_);
+    started_ = true;
+    fused_ = run(std::move(source_), std::move(chain_));
+    return fused_.begin();
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+  // e.g. to return the pipeline from a coroutine
+  operator generator_type() && {
+    return run(std::move(source_), std::move(chain_));
+  }
+
+  template <typename Adaptor,
+            std::enable_if_t<is_pipeline_adaptor_v<Adaptor>, int> = 0>
+  friend auto operator|(async_generator_pipe&& pipe, Adaptor adaptor) {
+    auto chain = std::move(pipe.chain_).then(std::move(adaptor));
+    return async_generator_pipe<Source, decltype(chain)>{
+        std::move(pipe.source_), std::move(chain)};
+  }
+
+ private:
+  static generator_type run(Source source, Chain chain) {
+    if (!chain.exhausted()) {
+      for (auto it = co_await source.begin(); it != source.end();) {
+        if (auto out = chain.push(*it)) {
+          co_yield *out;
+        }
+        if (chain.exhausted()) {
+          break;
+        }
+        co_await ++it;
+      }
+    }
+    for (std::size_t index = 0; index < Chain::kStages; ++index) {
+      if (auto out = chain.flush(index)) {
+        co_yield *out;
+      }
+    }
+  }
+
+  Source source_;
+  Chain chain_;
+  generator_type fused_;
+  bool started_ = false;
+};
+
+}  // namespace detail
+
+template <typename T,
+          typename Adaptor,
+          std::enable_if_t<detail::is_pipeline_adaptor_v<Adaptor>, int> = 0>
+auto operator|(generator<T>&& source, Adaptor adaptor) {
+  using record = std::remove_reference_t<typename generator<T>::reference>;
+  auto chain = detail::make_stage_chain<record>(std::move(adaptor));
+  return detail::generator_pipe<generator<T>, decltype(chain)>{
+      std::move(source), std::move(chain)};
+}
+
+template <typename T,
+          typename Adaptor,
+          std::enable_if_t<detail::is_pipeline_adaptor_v<Adaptor>, int> = 0>
+auto operator|(async_generator<T>&& source, Adaptor adaptor) {
+  using record =
+      std::remove_reference_t<typename async_generator<T>::reference>;
+  auto chain = detail::make_stage_chain<record>(std::move(adaptor));
+  return detail::async_generator_pipe<async_generator<T>, decltype(chain)>{
+      std::move(source), std::move(chain)};
+}
+
+}  // namespace coro
+
+#endif  // CPPCORO_PIPELINE_HPP_
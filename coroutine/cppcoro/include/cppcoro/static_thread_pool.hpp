@@ -0,0 +1,97 @@
+#ifndef CPPCORO_STATIC_THREAD_POOL_HPP_
+#define CPPCORO_STATIC_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coro {
+
+// @brief a fixed set of threads resuming the coroutines which co_await
+// schedule() on it, first come first served from one locked queue
+//
+// the children of when_all() which start with co_await pool.schedule() run
+// concurrently. the threads leave once the pool is destroyed and its queue
+// ran dry
+class static_thread_pool {
+ public:
+  explicit static_thread_pool(
+      std::size_t threads = std::thread::hardware_concurrency()) {
+    threads = threads == 0 ? 1 : threads;
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this] { run(); });
+    }
+  }
+  static_thread_pool(const static_thread_pool&) = delete;
+  static_thread_pool& operator=(const static_thread_pool&) = delete;
+  ~static_thread_pool() {
+    {
+      std::unique_lock lock{mutex_};
+      stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  class schedule_operation {
+   public:
+    explicit schedule_operation(static_thread_pool& pool) noexcept
+        : pool_{pool} {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> awaiting) {
+      pool_.post(awaiting);
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    static_thread_pool& pool_;
+  };
+
+  // @brief co_await pool.schedule() goes on on one of the pool's threads
+  [[nodiscard]] schedule_operation schedule() noexcept {
+    return schedule_operation{*this};
+  }
+
+  std::size_t thread_count() const noexcept { return threads_.size(); }
+
+ private:
+  void post(std::coroutine_handle<> h) {
+    {
+      std::unique_lock lock{mutex_};
+      queue_.push_back(h);
+    }
+    cv_.notify_one();
+  }
+  void run() {
+    for (;;) {
+      std::coroutine_handle<> h;
+      {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+        h = queue_.front();
+        queue_.pop_front();
+      }
+      h.resume();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::coroutine_handle<>> queue_;
+  bool stopped_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace coro
+
+#endif  // CPPCORO_STATIC_THREAD_POOL_HPP_
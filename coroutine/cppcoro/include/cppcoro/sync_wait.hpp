@@ -0,0 +1,28 @@
+#ifndef CPPCORO_SYNC_WAIT_HPP_
+#define CPPCORO_SYNC_WAIT_HPP_
+
+#include <cppcoro/detail/sync_wait_task.hpp>
+#include <cppcoro/detail/traits/remove_rvalue_reference.hpp>
+#include <cppcoro/traits/await_traits.hpp>
+#include <utility>
+
+namespace coro {
+
+// @brief block the calling thread until the awaitable completed, on this
+// thread or any other one, and return its result (or rethrow its
+// exception). the bridge from a plain function into coroutines. a result
+// returned as an rvalue reference is moved out before the frame holding it
+// is destroyed
+template <typename Awaitable>
+auto sync_wait(Awaitable&& awaitable) -> remove_rvalue_reference_t<
+    typename awaitable_traits<Awaitable&&>::await_result_t> {
+  auto task = detail::make_sync_wait_task(std::forward<Awaitable>(awaitable));
+  detail::sync_wait_event event;
+  task.start(event);
+  event.wait();
+  return task.result();
+}
+
+}  // namespace coro
+
+#endif  // CPPCORO_SYNC_WAIT_HPP_
@@ -6,6 +6,7 @@
 #include <coroutine>
 #include <cppcoro/broken_promise.hpp>
 #include <cppcoro/detail/traits/remove_rvalue_reference.hpp>
+#include <cppcoro/frame_pool.hpp>
 #include <cppcoro/stddef.hpp>
 #include <cppcoro/traits/await_traits.hpp>
 #include <cstdint>
@@ -21,8 +22,20 @@ class task;
 
 namespace detail {
 
-class task_promise_base {
-  friend struct final_awaitable;
+// the frames of all the tasks come from the frame pool
+class task_promise_base : public pooled_frame {
+  // symmetric transfer: the finished task returns the handle of its awaiter
+  // instead of resuming it, the caller's resume() jumps there as a tail call
+  // and a chain of co_await of any depth runs in constant stack
+  struct final_awaitable {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> coro) noexcept {
+      return static_cast<task_promise_base&>(coro.promise()).continuation_;
+    }
+    void await_resume() noexcept {}
+  };
 
  public:
   task_promise_base() noexcept = default;
@@ -35,67 +48,60 @@ class task_promise_base {
   }
 
  private:
-  struct final_awaitable {
-    bool await_ready() noexcept { return false; }
-    template <typename Promise>
-    std::coroutine_handle<> await_suspend(
-        std::coroutine_handle<Promise> coro) noexcept {
-      return coro.promise().continuation_;
-    }
-    void await_resume() noexcept {}
-  };
-
   std::coroutine_handle<> continuation_;
 };
 
 template <typename T>
-struct task_promise final : public task_promise_base {
+class task_promise final : public task_promise_base {
  public:
   task_promise() noexcept = default;
   ~task_promise() {}
 
   task<T> get_return_object() noexcept;
   void unhandled_exception() noexcept {
-    result_.emplace<kExceptionIndex>(std::current_exception());
+    result_.template emplace<kExceptionIndex>(std::current_exception());
   }
   template <typename Value,
             typename = std::enable_if_t<std::is_convertible_v<Value&&, T>>>
-  void return_value(Value&& v) {
-    result_.emplace<kValueIndex>(std::forward<Value>(v));
+  void return_value(Value&& v) noexcept(
+      std::is_nothrow_constructible_v<T, Value&&>) {
+    result_.template emplace<kValueIndex>(std::forward<Value>(v));
   }
   T& result() & {
     auto index = result_.index();
     if (index == kExceptionIndex) {
-      std::rethrow_exception(result_.get<kExceptionIndex>());
+      std::rethrow_exception(std::get<kExceptionIndex>(result_));
     }
     assert(index == kValueIndex);
-    return result_.get<kValueIndex>();
+    return std::get<kValueIndex>(result_);
   }
 
   // reference:
   // https://github.com/lewissbaker/cppcoro/issues/40#issuecomment-326864107
-  // don't really understand why.
-  // TODO: test
+  // `auto&& x = co_await f();` keeps a reference into the promise, which is
+  // gone with the temporary task at the end of the statement: the result of
+  // an rvalue task is returned by value for the types which are cheap to
+  // copy, and as an rvalue reference, to be moved out, for the others
   using rvalue_type = std::
-      conditional_t<std::is_arithmetic_v<T> || std::is_porint_v<T>, T, T&&>;
+      conditional_t<std::is_arithmetic_v<T> || std::is_pointer_v<T>, T, T&&>;
   rvalue_type result() && {
     auto index = result_.index();
     if (index == kExceptionIndex) {
-      std::rethrow_exception(result_.get<kExceptionIndex>());
+      std::rethrow_exception(std::get<kExceptionIndex>(result_));
     }
     assert(index == kValueIndex);
-    return result_.get<kValueIndex>();
+    return std::move(std::get<kValueIndex>(result_));
   }
 
  private:
-  constexpr int kMonostateIndex = 0;
-  constexpr int kValueIndex = 1;
-  constexpr int kExceptionIndex = 2;
+  static constexpr std::size_t kMonostateIndex = 0;
+  static constexpr std::size_t kValueIndex = 1;
+  static constexpr std::size_t kExceptionIndex = 2;
   std::variant<std::monostate, T, std::exception_ptr> result_;
 };
 
 template <>
-class task_promise<> : task_promise_base {
+class task_promise<void> final : public task_promise_base {
  public:
   task_promise() noexcept = default;
   task<void> get_return_object() noexcept;
@@ -113,8 +119,8 @@ class task_promise<> : task_promise_base {
   std::exception_ptr exception_;
 };
 
-template <>
-class task_promise<T&> : task_promise_base {
+template <typename T>
+class task_promise<T&> final : public task_promise_base {
  public:
   task_promise() noexcept = default;
 
@@ -147,7 +153,7 @@ class task_promise<T&> : task_promise_base {
 // co_await'ed
 template <typename T = void>
 class [[nodiscard]] task {
-  class awaitable_base;
+  struct awaitable_base;
 
  public:
   using promise_type = detail::task_promise<T>;
@@ -158,7 +164,7 @@ class [[nodiscard]] task {
 
   task(task&& other) noexcept : coro_{other.coro_} { other.coro_ = nullptr; }
   task& operator=(task&& other) noexcept {
-    if (std::addressof(other) != other) {
+    if (std::addressof(other) != this) {
       if (coro_) {
         coro_.destroy();
       }
@@ -200,7 +206,7 @@ class [[nodiscard]] task {
         if (!this->coro_) {
           throw broken_promise{};
         }
-        return std::move(this->coro_.promise().result());
+        return std::move(this->coro_.promise()).result();
       }
     };
     return awaitable{this->coro_};
@@ -213,7 +219,6 @@ class [[nodiscard]] task {
       using awaitable_base::awaitable_base;
       void await_resume() const noexcept {}
     };
-    ;
     return awaitable{this->coro_};
   }
 
@@ -223,16 +228,18 @@ class [[nodiscard]] task {
     awaitable_base(std::coroutine_handle<promise_type> coroutine) noexcept
         : coro_{coroutine} {}
 
-    bool await_ready() { return !coro || coro_.done(); }
-    std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept {
-      coro_.promise().set_continuation(h);
+    bool await_ready() const noexcept { return !coro_ || coro_.done(); }
+    // start the task as a tail call, its final_awaitable comes back here
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> awaiting) noexcept {
+      coro_.promise().set_continuation(awaiting);
       return coro_;
     }
   };
   std::coroutine_handle<promise_type> coro_ = nullptr;
 };
 template <typename Awaitable>
-auto make_task(Awaitable awaitable) -> task<remove_rvalue_referenc_t<
+auto make_task(Awaitable awaitable) -> task<remove_rvalue_reference_t<
     typename awaitable_traits<Awaitable>::await_result_t>> {
   co_return co_await std::forward<Awaitable>(awaitable);
 }
@@ -254,4 +261,4 @@ task<T&> task_promise<T&>::get_return_object() noexcept {
 }  // namespace detail
 }  // namespace coro
 
-#endif  // CPPCORO_TASK_HPP_
\ No newline at end of file
+#endif  // CPPCORO_TASK_HPP_
@@ -14,7 +14,7 @@ template <typename T>
 struct awaitable_traits<
     T,
     std::enable_if_t<coro::detail::is_awaiter<
-        decltype(coro::detail::get_awaiter(std::declval<T>()))>>> {
+        decltype(coro::detail::get_awaiter(std::declval<T>()))>::value>> {
   using awaiter_t = decltype(coro::detail::get_awaiter(std::declval<T>()));
   using await_result_t = decltype(std::declval<awaiter_t>().await_resume());
 };
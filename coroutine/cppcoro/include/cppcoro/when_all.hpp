@@ -0,0 +1,66 @@
+#ifndef CPPCORO_WHEN_ALL_HPP_
+#define CPPCORO_WHEN_ALL_HPP_
+
+#include <cppcoro/detail/traits/remove_rvalue_reference.hpp>
+#include <cppcoro/detail/void_value.hpp>
+#include <cppcoro/task.hpp>
+#include <cppcoro/traits/await_traits.hpp>
+#include <cppcoro/when_all_ready.hpp>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coro {
+
+namespace detail {
+// the tuple owns what the tasks return as rvalue references
+template <typename T>
+using non_void_t = std::
+    conditional_t<std::is_void_v<T>, void_value, remove_rvalue_reference_t<T>>;
+}  // namespace detail
+
+// @brief co_await when_all(a, b...) runs all the awaitables and resumes
+// with the tuple of their results, void_value for a void one. the first
+// exception, in argument order, is rethrown once all of them completed
+template <typename... Awaitables>
+[[nodiscard]] auto when_all(Awaitables... awaitables)
+    -> task<std::tuple<detail::non_void_t<
+        typename awaitable_traits<Awaitables&&>::await_result_t>...>> {
+  auto tasks = co_await when_all_ready(std::move(awaitables)...);
+  co_return std::apply(
+      [](auto&... tasks) {
+        return std::tuple<detail::non_void_t<
+            typename awaitable_traits<Awaitables&&>::await_result_t>...>{
+            std::move(tasks).non_void_result()...};
+      },
+      tasks);
+}
+
+// @brief the same for a fan-out of any size: the vector of the results, or
+// nothing for void awaitables
+template <typename Awaitable,
+          typename Result =
+              typename awaitable_traits<Awaitable&&>::await_result_t>
+[[nodiscard]] auto when_all(std::vector<Awaitable> awaitables)
+    -> task<std::conditional_t<std::is_void_v<Result>,
+                               void,
+                               std::vector<std::decay_t<Result>>>> {
+  auto tasks = co_await when_all_ready(std::move(awaitables));
+  if constexpr (std::is_void_v<Result>) {
+    for (auto& task : tasks) {
+      std::move(task).result();
+    }
+  } else {
+    std::vector<std::decay_t<Result>> results;
+    results.reserve(tasks.size());
+    for (auto& task : tasks) {
+      results.push_back(std::move(task).result());
+    }
+    co_return results;
+  }
+}
+
+}  // namespace coro
+
+#endif  // CPPCORO_WHEN_ALL_HPP_
@@ -0,0 +1,42 @@
+#ifndef CPPCORO_WHEN_ALL_READY_HPP_
+#define CPPCORO_WHEN_ALL_READY_HPP_
+
+#include <cppcoro/detail/when_all_ready_awaitable.hpp>
+#include <cppcoro/detail/when_all_task.hpp>
+#include <cppcoro/traits/await_traits.hpp>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coro {
+
+// @brief co_await when_all_ready(a, b...) runs all the awaitables and
+// resumes once every one of them completed, with a tuple of when_all_task:
+// result() of each returns its value or rethrows its exception. the
+// awaitables are taken by value: a task has to be moved in
+template <typename... Awaitables>
+[[nodiscard]] auto when_all_ready(Awaitables... awaitables) {
+  return detail::when_all_ready_awaitable<
+      std::tuple<detail::when_all_task<
+          typename awaitable_traits<Awaitables&&>::await_result_t>...>>{
+      detail::make_when_all_task(std::move(awaitables))...};
+}
+
+// @brief the same for a fan-out of any size, with a vector of when_all_task
+template <typename Awaitable,
+          typename Result =
+              typename awaitable_traits<Awaitable&&>::await_result_t>
+[[nodiscard]] auto when_all_ready(std::vector<Awaitable> awaitables) {
+  std::vector<detail::when_all_task<Result>> tasks;
+  tasks.reserve(awaitables.size());
+  for (auto& awaitable : awaitables) {
+    tasks.push_back(detail::make_when_all_task(std::move(awaitable)));
+  }
+  return detail::when_all_ready_awaitable<
+      std::vector<detail::when_all_task<Result>>>{std::move(tasks)};
+}
+
+}  // namespace coro
+
+#endif  // CPPCORO_WHEN_ALL_READY_HPP_
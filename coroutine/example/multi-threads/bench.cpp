@@ -0,0 +1,203 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "scheduler.hpp"
+
+// resumes per second of the scheduler as the number of workers grows: every
+// task yields kYields times, each yield is one more resume. then spawns per
+// second, every task spawning short-lived children, with the counters of the
+// frame pool. last the queueing delays of orders resumed by a network thread
+// while bulk tasks keep the workers busy, all at the same priority and then
+// the orders at kHigh and the bulk at kLow
+//
+// build: g++ -O2 -std=c++20 -pthread bench.cpp -o bench
+//        (-DCPPCORO_NO_FRAME_POOL for the frames from operator new)
+// usage: bench [max workers [tasks per worker]]
+
+constexpr long kYields = 100'000;
+constexpr long kSpawns = 1'000'000;
+constexpr int kOrders = 4;
+constexpr long kArrivals = 2'000;
+constexpr auto kArrivalInterval = std::chrono::microseconds(50);
+constexpr size_t kBulkPerWorker = 64;
+
+Task yielder(Scheduler& sch, long yields) {
+  for (long i = 0; i < yields; ++i) {
+    co_await sch.suspend();
+  }
+}
+
+Task leaf(long& sum, long value) {
+  sum += value;
+  co_return;
+}
+
+// every child is started and joined at once: a frame freed for each one
+// allocated, the next spawn finds it on the free list
+Task spawner(long spawns) {
+  long sum = 0;
+  for (long i = 0; i < spawns; ++i) {
+    co_await when_all(leaf(sum, i));
+  }
+}
+
+void spin(std::chrono::nanoseconds duration) {
+  auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+struct OrderSlot {
+  std::atomic<void*> waiting{nullptr};
+  std::atomic<std::int64_t> postedAt{0};
+  // from the post to the run, whatever the priorities
+  LatencyHistogram delays;
+};
+
+// parks the order until the network thread posts it
+struct Arrival {
+  OrderSlot& slot;
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<Task::promise_type> h) noexcept {
+    slot.waiting.store(h.address(), std::memory_order_release);
+  }
+  void await_resume() const noexcept {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    auto delay = now - std::chrono::steady_clock::duration(
+                           slot.postedAt.load(std::memory_order_relaxed));
+    slot.delays.record(std::chrono::nanoseconds(delay).count());
+  }
+};
+
+Task order(OrderSlot& slot, std::atomic<int>& done) {
+  co_await Arrival{slot};
+  for (long i = 0; i < kArrivals; ++i) {
+    spin(std::chrono::microseconds(1));
+    co_await Arrival{slot};
+  }
+  done.fetch_add(1);
+}
+
+Task bulk(Scheduler& sch, const std::atomic<int>& done) {
+  while (done.load(std::memory_order_relaxed) != kOrders) {
+    spin(std::chrono::microseconds(2));
+    co_await sch.yield();
+  }
+}
+
+void benchPriorities(size_t workers, Priority orders, Priority bulks) {
+  OrderSlot slots[kOrders];
+  std::atomic<int> done{0};
+  Scheduler sch{workers, true};
+  for (auto& slot : slots) {
+    sch.add_task(order(slot, done).get_handle(), orders);
+  }
+  for (size_t t = 0; t < workers * kBulkPerWorker; ++t) {
+    sch.add_task(bulk(sch, done).get_handle(), bulks);
+  }
+  sch.schedule();
+  std::thread network([&] {
+    while (done.load() != kOrders) {
+      std::this_thread::sleep_for(kArrivalInterval);
+      for (auto& slot : slots) {
+        auto address = slot.waiting.exchange(nullptr, std::memory_order_acquire);
+        if (address != nullptr) {
+          slot.postedAt.store(
+              std::chrono::steady_clock::now().time_since_epoch().count(),
+              std::memory_order_relaxed);
+          sch.post(
+              std::coroutine_handle<Task::promise_type>::from_address(address));
+        }
+      }
+    }
+  });
+  network.join();
+  sch.wait();
+  auto print = [](const char* name, const LatencyHistogram& delay) {
+    std::cout << "  " << std::setw(6) << name << ": " << std::setw(9)
+              << delay.count() << " runs  p50 " << std::setw(8)
+              << delay.percentile(0.5) << "ns  p99 " << std::setw(8)
+              << delay.percentile(0.99) << "ns  p99.9 " << std::setw(8)
+              << delay.percentile(0.999) << "ns  max " << std::setw(9)
+              << delay.max() << "ns\n";
+  };
+  const char* names[] = {"high", "normal", "low"};
+  auto delays = sch.delays();
+  for (size_t level = 0; level < kPriorities; ++level) {
+    if (delays[level].count() != 0) {
+      print(names[level], delays[level]);
+    }
+  }
+  LatencyHistogram orderDelays;
+  for (auto& slot : slots) {
+    orderDelays.merge(slot.delays);
+  }
+  print("orders", orderDelays);
+}
+
+int main(int argc, char* argv[]) {
+  using namespace std::chrono_literals;
+  size_t maxWorkers = std::thread::hardware_concurrency();
+  size_t tasksPerWorker = 8;
+  if (argc >= 2) {
+    maxWorkers = std::atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    tasksPerWorker = std::atoi(argv[2]);
+  }
+  for (size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+    auto tasks = workers * tasksPerWorker;
+    auto yields = kYields / static_cast<long>(tasksPerWorker);
+    Scheduler sch{workers};
+    for (size_t t = 0; t < tasks; ++t) {
+      sch.add_task(yielder(sch, yields).get_handle());
+    }
+    auto start = std::chrono::steady_clock::now();
+    sch.schedule();
+    sch.wait();
+    auto end = std::chrono::steady_clock::now();
+    // the first resume of every task starts it
+    auto resumes = static_cast<long>(tasks) * (yields + 1);
+    std::cout << std::setw(3) << workers << " workers:  " << std::setw(12)
+              << (1s * resumes) / (end - start) << " resumes/s\n";
+  }
+  for (size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+    auto tasks = workers * tasksPerWorker;
+    auto spawns = kSpawns / static_cast<long>(tasks);
+    auto before = coro::frame_pool::stats();
+    Scheduler sch{workers};
+    for (size_t t = 0; t < tasks; ++t) {
+      sch.add_task(spawner(spawns).get_handle());
+    }
+    auto start = std::chrono::steady_clock::now();
+    sch.schedule();
+    sch.wait();
+    auto end = std::chrono::steady_clock::now();
+    auto stats = coro::frame_pool::stats();
+    auto allocations = stats.allocations - before.allocations;
+    auto hits = stats.hits - before.hits;
+    std::cout << std::setw(3) << workers << " workers:  " << std::setw(12)
+              << (1s * static_cast<long>(tasks) * spawns) / (end - start)
+              << " spawns/s  frame pool hits " << std::fixed
+              << std::setprecision(1) << 100.0 * hits / allocations << "%\n";
+  }
+  auto stats = coro::frame_pool::stats();
+  std::cout << "frames:";
+  for (size_t cls = 0; cls < stats.sizes.size(); ++cls) {
+    if (stats.sizes[cls] != 0) {
+      std::cout << " <=" << (cls + 1) * coro::frame_pool::kGranularity
+                << "B:" << stats.sizes[cls];
+    }
+  }
+  std::cout << " >" << stats.sizes.size() * coro::frame_pool::kGranularity
+            << "B:" << stats.oversized << "\n";
+  std::cout << "queueing delay, " << maxWorkers
+            << " workers, orders and bulk at normal:\n";
+  benchPriorities(maxWorkers, Priority::kNormal, Priority::kNormal);
+  std::cout << "queueing delay, orders at high, bulk at low:\n";
+  benchPriorities(maxWorkers, Priority::kHigh, Priority::kLow);
+  return 0;
+}
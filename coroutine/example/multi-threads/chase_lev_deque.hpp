@@ -0,0 +1,125 @@
+#ifndef CHASE_LEV_DEQUE_HPP_
+#define CHASE_LEV_DEQUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// work-stealing deque of Chase and Lev, with the memory orders of "Correct
+// and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013).
+// the owner pushes and pops at the bottom (LIFO), any thread steals at the
+// top (FIFO). Tp is stored in atomics, so it has to be a pointer or a small
+// trivially copyable value
+template <class Tp>
+class ChaseLevDeque {
+ public:
+  explicit ChaseLevDeque(size_t capacity = 256)
+      : array_(new Array(roundUp(capacity))) {
+    arrays_.emplace_back(array_.load(std::memory_order_relaxed));
+  }
+  ChaseLevDeque(const ChaseLevDeque&) = delete;
+  ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+  // owner only
+  void push(Tp value) {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto t = top_.load(std::memory_order_acquire);
+    auto a = array_.load(std::memory_order_relaxed);
+    if (b - t > a->capacity() - 1) {
+      a = grow(a, t, b);
+    }
+    a->put(b, value);
+    // a release store rather than the fence of the paper, same code on x86
+    // and visible to the thread sanitizer
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+  // owner only, the most recently pushed value or false if empty
+  bool pop(Tp& value) {
+    auto b = bottom_.load(std::memory_order_relaxed) - 1;
+    auto a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    value = a->get(b);
+    if (t == b) {
+      // the last one, race the thieves for it
+      auto won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+  // any thread, the oldest value or false if empty or lost to another thief
+  bool steal(Tp& value) {
+    auto t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    auto a = array_.load(std::memory_order_acquire);
+    value = a->get(t);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+  // only a snapshot
+  bool empty() const noexcept {
+    auto t = top_.load(std::memory_order_acquire);
+    auto b = bottom_.load(std::memory_order_acquire);
+    return t >= b;
+  }
+
+ private:
+  class Array {
+   public:
+    explicit Array(std::int64_t capacity)
+        : mask_(capacity - 1),
+          slots_(std::make_unique<std::atomic<Tp>[]>(capacity)) {}
+    std::int64_t capacity() const noexcept { return mask_ + 1; }
+    Tp get(std::int64_t idx) const noexcept {
+      return slots_[idx & mask_].load(std::memory_order_relaxed);
+    }
+    void put(std::int64_t idx, Tp value) noexcept {
+      slots_[idx & mask_].store(value, std::memory_order_relaxed);
+    }
+
+   private:
+    std::int64_t mask_;
+    std::unique_ptr<std::atomic<Tp>[]> slots_;
+  };
+
+  static std::int64_t roundUp(size_t capacity) {
+    std::int64_t pow2 = 1;
+    while (pow2 < static_cast<std::int64_t>(capacity)) {
+      pow2 *= 2;
+    }
+    return pow2;
+  }
+  // a thief may still read the old array: it lives as long as the deque
+  Array* grow(Array* old, std::int64_t top, std::int64_t bottom) {
+    auto bigger = new Array(old->capacity() * 2);
+    for (auto idx = top; idx < bottom; ++idx) {
+      bigger->put(idx, old->get(idx));
+    }
+    arrays_.emplace_back(bigger);
+    array_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  alignas(hardware_destructive_interference_size) std::atomic<std::int64_t>
+      top_{0};
+  alignas(hardware_destructive_interference_size) std::atomic<std::int64_t>
+      bottom_{0};
+  std::atomic<Array*> array_;
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+#endif  // CHASE_LEV_DEQUE_HPP_
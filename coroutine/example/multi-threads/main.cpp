@@ -1,4 +1,8 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
 #include <iostream>
+#include <string>
 
 #include "scheduler.hpp"
 
@@ -20,10 +24,68 @@ Task jobB(Scheduler& sch) {
 }
 
 
+Task child(Scheduler& sch, int idx) {
+    co_await sch.suspend();
+    std::cout << "child " << idx << ": work is done\n";
+}
+
+
+Task logger(int n) {
+    std::cout << "logger: " << n << " children joined\n";
+    co_return;
+}
+
+
+// fans out to children created on the fly, the scheduler keeps running
+// until the detached logger is done too
+Task jobC(Scheduler& sch, int n) {
+    std::cout << "jobC: enterred\n";
+    std::vector<Task> children;
+    for (int idx = 0; idx < n; ++idx) {
+        children.push_back(child(sch, idx));
+    }
+    co_await when_all(std::move(children));
+    co_await when_all(child(sch, n), child(sch, n + 1));
+    sch.spawn(logger(n + 2));
+    std::cout << "JobC: work is done\n";
+}
+
+
+// sleeps without holding a worker, the reader only runs once the writer
+// woke up and the pipe got readable
+Task writer(Scheduler& sch, int fd) {
+    using namespace std::chrono_literals;
+    for (int idx = 0; idx < 3; ++idx) {
+        co_await sch.sleep_for(10ms);
+        char c = '0' + idx;
+        co_await sch.async_write(fd, &c, 1);
+    }
+    ::close(fd);
+}
+
+
+Task reader(Scheduler& sch, int fd) {
+    char buf[16];
+    ssize_t n;
+    while ((n = co_await sch.async_read(fd, buf, sizeof(buf))) > 0) {
+        std::cout << "reader: got " << std::string(buf, n) << "\n";
+        co_await sch.yield();
+    }
+    std::cout << "reader: " << (n == 0 ? "end of pipe" : "error") << "\n";
+    ::close(fd);
+}
+
+
 int main(int argc, char* argv[]) {
     Scheduler sch;
     sch.add_task(jobA(sch).get_handle());
     sch.add_task(jobB(sch).get_handle());
+    sch.add_task(jobC(sch, 4).get_handle());
+    int fds[2];
+    if (::pipe2(fds, O_NONBLOCK) == 0) {
+        sch.add_task(reader(sch, fds[0]).get_handle());
+        sch.add_task(writer(sch, fds[1]).get_handle());
+    }
     sch.schedule();
     sch.wait();
 
@@ -0,0 +1,267 @@
+#ifndef REACTOR_HPP_
+#define REACTOR_HPP_
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace detail {
+// a coroutine waiting until a file descriptor is ready. complete() retries
+// the operation: false while it would still block, else result is the
+// byte count or -errno
+struct IoWaiter {
+  std::coroutine_handle<> handle;
+  int fd;
+  void* buffer;
+  size_t size;
+  bool write;
+  ssize_t result = 0;
+
+  bool complete() noexcept {
+    auto n = write ? ::write(fd, buffer, size) : ::read(fd, buffer, size);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return false;
+    }
+    result = n < 0 ? -errno : n;
+    return true;
+  }
+};
+}  // namespace detail
+
+// the events a suspended coroutine waits for, behind one epoll instance:
+// the timers, a heap whose earliest deadline arms a timerfd, and the file
+// descriptors, armed one-shot for the directions someone waits for.
+// poll() hands out the coroutines whose event fired, it never resumes them
+class Reactor {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  Reactor();
+  ~Reactor();
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+
+  // any thread, h is handed out by the first poll() after deadline
+  void addTimer(clock::time_point deadline, std::coroutine_handle<> h);
+  // any thread, waiter has to be non-blocking. false if it did not wait:
+  // result tells why (-EBUSY if another coroutine waits already for this
+  // direction of the descriptor). once it waits it may be handed out at
+  // any time
+  bool watch(detail::IoWaiter& waiter);
+  // one thread at a time: wait up to timeout milliseconds (-1 for ever)
+  // and append the coroutines whose event fired to ready
+  void poll(int timeout, std::vector<std::coroutine_handle<>>& ready);
+  // any thread, interrupt the poll() blocked in another one
+  void wake() noexcept;
+
+ private:
+  struct Timer {
+    clock::time_point deadline;
+    // same deadline, first come first served
+    std::uint64_t seq;
+    std::coroutine_handle<> handle;
+
+    bool operator>(const Timer& other) const noexcept {
+      return deadline != other.deadline ? deadline > other.deadline
+                                        : seq > other.seq;
+    }
+  };
+  struct Interest {
+    detail::IoWaiter* reader = nullptr;
+    detail::IoWaiter* writer = nullptr;
+  };
+
+  static constexpr int kEvents = 64;
+
+  void fireTimers(std::vector<std::coroutine_handle<>>& ready);
+  void arm(clock::time_point deadline);
+  void dispatch(int fd,
+                std::uint32_t events,
+                std::vector<std::coroutine_handle<>>& ready);
+  int rearm(int fd, const Interest& interest);
+
+  int epollFd_;
+  int wakeFd_;
+  int timerFd_;
+  std::mutex timerMu_;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+  std::uint64_t timerSeq_ = 0;
+  // deadline the timerfd is armed for, under timerMu_
+  clock::time_point armed_ = clock::time_point::max();
+  std::mutex ioMu_;
+  std::unordered_map<int, Interest> interests_;
+};
+
+Reactor::Reactor() {
+  epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  timerFd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (epollFd_ < 0 || wakeFd_ < 0 || timerFd_ < 0) {
+    throw std::system_error(errno, std::system_category(), "reactor");
+  }
+  for (auto fd : {wakeFd_, timerFd_}) {
+    ::epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+      throw std::system_error(errno, std::system_category(), "epoll_ctl");
+    }
+  }
+}
+
+Reactor::~Reactor() {
+  ::close(timerFd_);
+  ::close(wakeFd_);
+  ::close(epollFd_);
+}
+
+void Reactor::addTimer(clock::time_point deadline,
+                       std::coroutine_handle<> h) {
+  std::unique_lock lock{timerMu_};
+  timers_.push({deadline, timerSeq_++, h});
+  // a poll() blocked meanwhile wakes up through the timerfd
+  if (deadline < armed_) {
+    arm(deadline);
+  }
+}
+
+// steady_clock is CLOCK_MONOTONIC on Linux
+void Reactor::arm(clock::time_point deadline) {
+  armed_ = deadline;
+  ::itimerspec spec{};
+  if (deadline != clock::time_point::max()) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  deadline.time_since_epoch())
+                  .count();
+    // zero would disarm it
+    ns = std::max<std::int64_t>(ns, 1);
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+  }
+  ::timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void Reactor::fireTimers(std::vector<std::coroutine_handle<>>& ready) {
+  std::unique_lock lock{timerMu_};
+  if (timers_.empty()) {
+    return;
+  }
+  auto now = clock::now();
+  while (!timers_.empty() && timers_.top().deadline <= now) {
+    ready.push_back(timers_.top().handle);
+    timers_.pop();
+  }
+  auto next = timers_.empty() ? clock::time_point::max()
+                              : timers_.top().deadline;
+  if (next != armed_) {
+    arm(next);
+  }
+}
+
+bool Reactor::watch(detail::IoWaiter& waiter) {
+  std::unique_lock lock{ioMu_};
+  auto& interest = interests_[waiter.fd];
+  auto& slot = waiter.write ? interest.writer : interest.reader;
+  if (slot != nullptr) {
+    waiter.result = -EBUSY;
+    return false;
+  }
+  slot = &waiter;
+  if (auto error = rearm(waiter.fd, interest)) {
+    slot = nullptr;
+    if (interest.reader == nullptr && interest.writer == nullptr) {
+      interests_.erase(waiter.fd);
+    }
+    waiter.result = -error;
+    return false;
+  }
+  return true;
+}
+
+// a descriptor stays registered, disabled, once its one-shot event fired,
+// unless it was closed since: modify it or add it again
+int Reactor::rearm(int fd, const Interest& interest) {
+  ::epoll_event event{};
+  event.events = EPOLLONESHOT;
+  event.events |= interest.reader != nullptr ? EPOLLIN : 0u;
+  event.events |= interest.writer != nullptr ? EPOLLOUT : 0u;
+  event.data.fd = fd;
+  if (::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == 0) {
+    return 0;
+  }
+  if (errno == ENOENT &&
+      ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0) {
+    return 0;
+  }
+  return errno;
+}
+
+void Reactor::dispatch(int fd,
+                       std::uint32_t events,
+                       std::vector<std::coroutine_handle<>>& ready) {
+  std::unique_lock lock{ioMu_};
+  auto it = interests_.find(fd);
+  if (it == interests_.end()) {
+    return;
+  }
+  auto& interest = it->second;
+  // an error or a hang up completes both directions
+  auto failed = (events & (EPOLLERR | EPOLLHUP)) != 0;
+  for (auto [slot, mask] : {std::pair{&interest.reader, EPOLLIN},
+                            std::pair{&interest.writer, EPOLLOUT}}) {
+    auto waiter = *slot;
+    if (waiter != nullptr && ((events & mask) != 0 || failed) &&
+        waiter->complete()) {
+      ready.push_back(waiter->handle);
+      *slot = nullptr;
+    }
+  }
+  if (interest.reader == nullptr && interest.writer == nullptr) {
+    interests_.erase(it);
+  } else if (auto error = rearm(fd, interest)) {
+    // nothing would wake them any more
+    for (auto slot : {&interest.reader, &interest.writer}) {
+      if (*slot != nullptr) {
+        (*slot)->result = -error;
+        ready.push_back((*slot)->handle);
+      }
+    }
+    interests_.erase(it);
+  }
+}
+
+void Reactor::poll(int timeout, std::vector<std::coroutine_handle<>>& ready) {
+  ::epoll_event events[kEvents];
+  auto n = ::epoll_wait(epollFd_, events, kEvents, timeout);
+  for (int idx = 0; idx < n; ++idx) {
+    auto fd = events[idx].data.fd;
+    if (fd == wakeFd_ || fd == timerFd_) {
+      std::uint64_t count;
+      [[maybe_unused]] auto _ = ::read(fd, &count, sizeof(count));
+    } else {
+      dispatch(fd, events[idx].events, ready);
+    }
+  }
+  fireTimers(ready);
+}
+
+void Reactor::wake() noexcept {
+  std::uint64_t one = 1;
+  [[maybe_unused]] auto _ = ::write(wakeFd_, &one, sizeof(one));
+}
+
+#endif  // REACTOR_HPP_
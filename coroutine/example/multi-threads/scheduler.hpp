@@ -1,24 +1,72 @@
 #ifndef SCHEDULER_HPP_
 #define SCHEDULER_HPP_
 
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
 #include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <stack>
 #include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../../../utility/circular buffer/include/latency_histogram.hpp"
+#include "../../cppcoro/include/cppcoro/frame_pool.hpp"
+#include "chase_lev_deque.hpp"
+#include "reactor.hpp"
+
+class Scheduler;
+
+// the run queue a task waits in. the workers serve the higher levels first,
+// but a lower level with work which was passed over kAgingLimit times gets
+// the next turn: a flood of kHigh tasks slows the kLow ones down, it does
+// not starve them
+enum class Priority : std::uint8_t { kHigh, kNormal, kLow };
+inline constexpr size_t kPriorities = 3;
+
+namespace detail {
+// the children of one when_all() still running, plus one for the parent
+// until it suspended
+struct JoinState {
+  std::atomic<size_t> remaining;
+  std::coroutine_handle<> parent;
+};
+}  // namespace detail
 
 struct Task {
-  struct promise_type {
+  struct promise_type;
+  // the task may have been posted to another worker while the one which ran
+  // it was still returning from resume(): it reports its end itself, and
+  // resumes the parent waiting in when_all() if it is the last child
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  // the frames come from the thread-local free lists of the frame pool, a
+  // frame destroyed by a thief goes to the thief's lists
+  struct promise_type : coro::pooled_frame {
     std::suspend_always initial_suspend() noexcept { return {}; }
-    std::suspend_always final_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
 
     void unhandled_exception() { ; }
     void return_void() {}
     Task get_return_object() noexcept {
       return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
     }
+
+    Scheduler* scheduler = nullptr;
+    detail::JoinState* join = nullptr;
+    Priority priority = Priority::kNormal;
+    // when it was last queued, in ns of the steady clock
+    std::int64_t queuedAt = 0;
   };
 
   auto get_handle() noexcept -> std::coroutine_handle<promise_type> {
@@ -27,97 +75,691 @@ struct Task {
   std::coroutine_handle<promise_type> handle_;
 };
 
+// work-stealing scheduler: every worker runs the coroutines of its own
+// Chase-Lev deque and steals from a random victim once it ran dry.
+//
+// - every priority has its own deque and injection queue, and every task
+//   the priority it was added or spawned with, or set with set_priority()
+// - a coroutine posted from a worker goes to its LIFO slot and runs next,
+//   while the data which woke it is still in cache, unless there is work of
+//   a higher priority. the one it displaces goes to the deque, where
+//   thieves can take it
+// - a coroutine posted from outside (schedule(), a producer thread) goes to
+//   the injection queue, the only lock, which the workers drain in batches
+// - yield() defers the coroutine behind the local work, sleep_for(),
+//   sleep_until(), async_read() and async_write() leave it to the reactor
+//   until its event fired: nothing polls a coroutine which cannot run
+// - a worker parks only after it found nothing in its slot, its deque, the
+//   injection queue and every other deque. the first one to park waits in
+//   epoll_wait() for the reactor, the others for new work, which wakes one
+//   of them only when no worker is already searching for some. a busy
+//   worker polls the reactor too, without blocking, every kInjectInterval
+//   runs. a worker done with the reactor wakes a parked one to take it
 class Scheduler {
  public:
-  Scheduler(size_t num = std::thread::hardware_concurrency());
-  void add_task(std::coroutine_handle<> h);
+  // measureDelays: the time every task waits in a run queue, from being
+  // queued to being resumed, goes to a histogram per priority
+  Scheduler(size_t num = std::thread::hardware_concurrency(),
+            bool measureDelays = false);
+  ~Scheduler();
+  void add_task(std::coroutine_handle<Task::promise_type> h,
+                Priority priority = Priority::kNormal);
   void wait();
   void stop();
   void schedule();
-  auto suspend() -> std::suspend_always { return {}; }
+  // make a suspended task runnable again, from any thread. only a Task can
+  // be posted, or awaited on yield(), sleep_for() and async IO: its priority
+  // is in the promise
+  void post(std::coroutine_handle<Task::promise_type> h);
+  // start a new task, from a running task (or before schedule()): the
+  // scheduler stops once every task it knows of is done, so a task which
+  // spawns keeps it running until its children are counted
+  void spawn(Task task, Priority priority = Priority::kNormal);
+  // the queueing delays of all the workers, once wait() returned
+  std::array<LatencyHistogram, kPriorities> delays() const;
+
+  // the running task is queued with priority from its next suspension on
+  struct SetPriority {
+    Priority priority;
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<Task::promise_type> h) noexcept {
+      h.promise().priority = priority;
+      return false;
+    }
+    void await_resume() const noexcept {}
+  };
+  auto set_priority(Priority priority) -> SetPriority { return {priority}; }
+
+  struct Suspend {
+    Scheduler& sch;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<Task::promise_type> h) {
+      sch.defer(h);
+    }
+    void await_resume() const noexcept {}
+  };
+  auto yield() -> Suspend { return {*this}; }
+  auto suspend() -> Suspend { return {*this}; }
+
+  struct Sleep {
+    Scheduler& sch;
+    Reactor::clock::time_point deadline;
+    bool await_ready() const { return deadline <= Reactor::clock::now(); }
+    void await_suspend(std::coroutine_handle<Task::promise_type> h) {
+      sch.reactor_.addTimer(deadline, h);
+    }
+    void await_resume() const noexcept {}
+  };
+  auto sleep_until(Reactor::clock::time_point deadline) -> Sleep {
+    return {*this, deadline};
+  }
+  template <class Rep, class Period>
+  auto sleep_for(std::chrono::duration<Rep, Period> duration) -> Sleep {
+    return {*this,
+            Reactor::clock::now() +
+                std::chrono::duration_cast<Reactor::clock::duration>(duration)};
+  }
+
+  // the result of read(2) or write(2) on a non-blocking descriptor, -errno
+  // on error: the coroutine waits only if the call would block
+  class Io : private detail::IoWaiter {
+   public:
+    Io(Scheduler& sch, int fd, void* buffer, size_t size, bool write)
+        : detail::IoWaiter{{}, fd, buffer, size, write}, sch_(sch) {}
+    bool await_ready() noexcept { return complete(); }
+    bool await_suspend(std::coroutine_handle<Task::promise_type> h) {
+      handle = h;
+      return sch_.reactor_.watch(*this);
+    }
+    ssize_t await_resume() const noexcept { return result; }
+
+   private:
+    Scheduler& sch_;
+  };
+  auto async_read(int fd, void* buffer, size_t size) -> Io {
+    return {*this, fd, buffer, size, false};
+  }
+  auto async_write(int fd, const void* buffer, size_t size) -> Io {
+    return {*this, fd, const_cast<void*>(buffer), size, true};
+  }
 
  private:
-  void process(std::coroutine_handle<> h);
-  std::queue<std::coroutine_handle<>> tasks_;
+  // consecutive runs from the LIFO slot before the deque gets a turn, two
+  // coroutines waking each other would starve it otherwise
+  static constexpr int kLifoLimit = 3;
+  // the injection queue is checked first every kInjectInterval runs
+  static constexpr std::uint32_t kInjectInterval = 61;
+  // coroutines moved from the injection queue to the deque at most at once
+  static constexpr size_t kInjectBatch = 32;
+  // picks of a higher priority a level with work waits for at most
+  static constexpr int kAgingLimit = 8;
+  static constexpr size_t hardware_destructive_interference_size = 64;
+
+  struct alignas(hardware_destructive_interference_size) Worker {
+    std::array<ChaseLevDeque<void*>, kPriorities> deques;
+    // owner only
+    std::coroutine_handle<> lifo;
+    int lifoRuns = 0;
+    std::array<std::vector<std::coroutine_handle<>>, kPriorities> deferred;
+    // picks since each level with work got its turn
+    std::array<int, kPriorities> passed{};
+    std::uint32_t ticks = 0;
+    std::uint64_t rng = 0;
+    // handed out by the reactor
+    std::vector<std::coroutine_handle<>> fired;
+    std::array<LatencyHistogram, kPriorities> delays;
+  };
+
+  friend Task::FinalAwaiter;
+  void finish();
+  void defer(std::coroutine_handle<Task::promise_type> h);
+  void run(Worker& w);
+  std::coroutine_handle<> next(Worker& w);
+  std::coroutine_handle<> popLocal(Worker& w);
+  std::coroutine_handle<> popInjected(Worker& w, size_t level);
+  std::coroutine_handle<> steal(Worker& w);
+  int pickLevel(Worker& w);
+  bool hasWork(const Worker& w, size_t level) const;
+  bool hasWork() const;
+  // every handle in the queues and in the reactor is a Task's: only post(),
+  // defer() and the awaiters above queue them, and they take Tasks only
+  static Task::promise_type& promiseOf(std::coroutine_handle<> h) noexcept;
+  static size_t levelOf(std::coroutine_handle<> h) noexcept;
+  static std::int64_t nowNs() noexcept;
+  void stamp(std::coroutine_handle<> h) noexcept;
+  void record(Worker& w, std::coroutine_handle<> h) noexcept;
+  void inject(std::coroutine_handle<> h);
+  void pushLocal(Worker& w, std::coroutine_handle<> h);
+  void notify();
+  void wakeAll();
+  void park(Worker& w);
+  bool tryPoll(Worker& w);
+  void releaseReactor();
+  void pushFired(Worker& w);
+  Worker* currentWorker() const noexcept;
+
+  static thread_local Worker* current_;
+  static thread_local Scheduler* currentScheduler_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  // the tasks added before schedule(), under injectMu_
   std::vector<std::coroutine_handle<>> commitedTask_;
-  std::vector<std::thread> workers_;
-  std::mutex mu_;
-  std::condition_variable cv_;
-  bool stopped_ = {false};
-  std::atomic<size_t> finished_{0};
+  bool scheduled_ = false;
+  std::mutex injectMu_;
+  std::array<std::deque<std::coroutine_handle<>>, kPriorities> injected_;
+  std::array<std::atomic<size_t>, kPriorities> injectedSize_{};
+  bool measureDelays_;
+  // workers stealing right now, parked workers and their generation
+  alignas(hardware_destructive_interference_size) std::atomic<int>
+      searching_{0};
+  std::atomic<int> sleepers_{0};
+  std::atomic<std::uint32_t> epoch_{0};
+  // a worker owns the reactor, it is blocked in epoll_wait()
+  std::atomic<bool> polling_{false};
+  std::atomic<bool> pollerBlocked_{false};
+  std::atomic<bool> stopped_{false};
+  // tasks added or spawned and not finished yet
+  std::atomic<size_t> outstanding_{0};
+  Reactor reactor_;
 };
 
-Scheduler::Scheduler(size_t num) {
+// co_await when_all(child(), child()...) runs the children as new tasks of
+// the scheduler of the awaiting task and resumes it once all of them are
+// done, when_all(std::vector<Task>) joins a fan-out of any size
+class WhenAll {
+ public:
+  explicit WhenAll(std::vector<Task> tasks) : tasks_(std::move(tasks)) {}
+
+  bool await_ready() const noexcept { return tasks_.empty(); }
+  bool await_suspend(std::coroutine_handle<Task::promise_type> parent) {
+    auto sch = parent.promise().scheduler;
+    state_.remaining.store(tasks_.size() + 1, std::memory_order_relaxed);
+    state_.parent = parent;
+    // the children wait in the queue of the parent
+    for (auto task : tasks_) {
+      task.get_handle().promise().join = &state_;
+      sch->spawn(task, parent.promise().priority);
+    }
+    // the parent's own count: false if the children are already done, once
+    // it is dropped the parent may run anywhere and this is gone
+    return state_.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  std::vector<Task> tasks_;
+  detail::JoinState state_;
+};
+
+inline auto when_all(std::vector<Task> tasks) {
+  return WhenAll{std::move(tasks)};
+}
+template <class... Tasks>
+auto when_all(Tasks... tasks)
+  requires(std::is_same_v<Tasks, Task> && ...)
+{
+  return WhenAll{std::vector<Task>{tasks...}};
+}
+
+inline thread_local Scheduler::Worker* Scheduler::current_ = nullptr;
+inline thread_local Scheduler* Scheduler::currentScheduler_ = nullptr;
+
+Scheduler::Scheduler(size_t num, bool measureDelays)
+    : measureDelays_(measureDelays) {
+  num = std::max<size_t>(num, 1);
   workers_.reserve(num);
   for (size_t idx = 0; idx < num; ++idx) {
-    workers_.emplace_back([this]() {
-      while (true) {
-        std::coroutine_handle<> t;
-        {
-          std::unique_lock lock{mu_};
-          cv_.wait(lock, [this] { return stopped_ || (!tasks_.empty()); });
-          if (stopped_) {
-            return;
-          }
-          t = tasks_.front();
-          tasks_.pop();
-        }
-        if (t) {
-          process(t);
-        }
-      }
-    });
+    workers_.push_back(std::make_unique<Worker>());
+    workers_.back()->rng = 0x9e3779b97f4a7c15ull * (idx + 1);
+  }
+  threads_.reserve(num);
+  for (size_t idx = 0; idx < num; ++idx) {
+    threads_.emplace_back([this, idx]() { run(*workers_[idx]); });
   }
 }
 
-void Scheduler::process(std::coroutine_handle<> h) {
-  h.resume();
-  if (!h.done()) {
-    std::unique_lock lock{mu_};
-    tasks_.push(h);
-    cv_.notify_one();
-  } else {
-    h.destroy();
-    if (finished_.fetch_add(1) + 1 == commitedTask_.size()) {
-      {
-        std::unique_lock lock{mu_};
-        stopped_ = true;
-      }
+Scheduler::~Scheduler() {
+  if (!threads_.empty() && threads_.front().joinable()) {
+    stop();
+  }
+}
 
-      cv_.notify_all();
+void Task::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept {
+  auto sch = h.promise().scheduler;
+  auto join = h.promise().join;
+  h.destroy();
+  // the parent is resumed before this task counts as finished, so that
+  // the outstanding work never drops to zero in between
+  if (join != nullptr) {
+    auto parent = join->parent;
+    if (join->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // WhenAll is awaited by Tasks only
+      sch->post(std::coroutine_handle<promise_type>::from_address(
+          parent.address()));
     }
   }
+  if (sch != nullptr) {
+    sch->finish();
+  }
+}
+
+void Scheduler::finish() {
+  if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    stopped_.store(true);
+    wakeAll();
+  }
 }
 
-void Scheduler::add_task(std::coroutine_handle<> h) {
-  std::unique_lock lock{mu_};
-  commitedTask_.push_back(h);
+void Scheduler::add_task(std::coroutine_handle<Task::promise_type> h,
+                         Priority priority) {
+  h.promise().scheduler = this;
+  h.promise().priority = priority;
+  outstanding_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::unique_lock lock{injectMu_};
+    if (!scheduled_) {
+      commitedTask_.push_back(h);
+      return;
+    }
+  }
+  stamp(h);
+  inject(h);
+}
+
+void Scheduler::spawn(Task task, Priority priority) {
+  auto h = task.get_handle();
+  h.promise().scheduler = this;
+  h.promise().priority = priority;
+  outstanding_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::unique_lock lock{injectMu_};
+    if (!scheduled_) {
+      commitedTask_.push_back(h);
+      return;
+    }
+  }
+  stamp(h);
+  // a child goes to the deque, not to the LIFO slot: the parent keeps
+  // running and an idle worker may steal the child
+  if (auto w = currentWorker()) {
+    pushLocal(*w, h);
+  } else {
+    inject(h);
+  }
 }
 
 void Scheduler::schedule() {
   {
-    std::unique_lock lock{mu_};
+    std::unique_lock lock{injectMu_};
+    scheduled_ = true;
     for (auto t : commitedTask_) {
-      tasks_.push(t);
+      stamp(t);
+      injected_[levelOf(t)].push_back(t);
     }
+    commitedTask_.clear();
+    for (size_t level = 0; level < kPriorities; ++level) {
+      injectedSize_[level].store(injected_[level].size());
+    }
+  }
+  if (outstanding_.load() == 0) {
+    stopped_.store(true);
   }
-  cv_.notify_all();
+  wakeAll();
 }
 
 void Scheduler::wait() {
-  for (auto& th : workers_) {
+  for (auto& th : threads_) {
     th.join();
   }
 }
 
 void Scheduler::stop() {
+  stopped_.store(true);
+  wakeAll();
+  wait();
+}
+
+Scheduler::Worker* Scheduler::currentWorker() const noexcept {
+  return currentScheduler_ == this ? current_ : nullptr;
+}
+
+std::array<LatencyHistogram, kPriorities> Scheduler::delays() const {
+  std::array<LatencyHistogram, kPriorities> total;
+  for (auto& worker : workers_) {
+    for (size_t level = 0; level < kPriorities; ++level) {
+      total[level].merge(worker->delays[level]);
+    }
+  }
+  return total;
+}
+
+Task::promise_type& Scheduler::promiseOf(std::coroutine_handle<> h) noexcept {
+  return std::coroutine_handle<Task::promise_type>::from_address(h.address())
+      .promise();
+}
+
+size_t Scheduler::levelOf(std::coroutine_handle<> h) noexcept {
+  return static_cast<size_t>(promiseOf(h).priority);
+}
+
+std::int64_t Scheduler::nowNs() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Scheduler::stamp(std::coroutine_handle<> h) noexcept {
+  if (measureDelays_) {
+    promiseOf(h).queuedAt = nowNs();
+  }
+}
+
+void Scheduler::record(Worker& w, std::coroutine_handle<> h) noexcept {
+  if (measureDelays_) {
+    auto& promise = promiseOf(h);
+    auto now = nowNs();
+    w.delays[levelOf(h)].record(
+        static_cast<std::uint64_t>(std::max<std::int64_t>(
+            now - promise.queuedAt, 0)));
+  }
+}
+
+void Scheduler::post(std::coroutine_handle<Task::promise_type> h) {
+  stamp(h);
+  auto w = currentWorker();
+  if (w == nullptr) {
+    inject(h);
+    return;
+  }
+  if (w->lifo) {
+    pushLocal(*w, w->lifo);
+  }
+  w->lifo = h;
+}
+
+void Scheduler::defer(std::coroutine_handle<Task::promise_type> h) {
+  stamp(h);
+  auto w = currentWorker();
+  if (w == nullptr) {
+    inject(h);
+    return;
+  }
+  w->deferred[levelOf(h)].push_back(h);
+}
+
+void Scheduler::inject(std::coroutine_handle<> h) {
+  auto level = levelOf(h);
   {
-    std::unique_lock lock{mu_};
-    stopped_ = true;
+    std::unique_lock lock{injectMu_};
+    injected_[level].push_back(h);
+    injectedSize_[level].store(injected_[level].size(),
+                               std::memory_order_relaxed);
   }
+  notify();
+}
 
-  cv_.notify_all();
-  wait();
+void Scheduler::pushLocal(Worker& w, std::coroutine_handle<> h) {
+  w.deques[levelOf(h)].push(h.address());
+  notify();
+}
+
+// wake a parked worker for new work, unless a searching one will find it.
+// the fence pairs with the one of park(): either the parked worker sees
+// the work when it checks again, or we see it parked. the poller is woken
+// last, it waits for the reactor in the meantime
+void Scheduler::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (searching_.load(std::memory_order_relaxed) != 0) {
+    return;
+  }
+  if (sleepers_.load(std::memory_order_relaxed) != 0) {
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_one();
+  } else if (pollerBlocked_.load(std::memory_order_relaxed)) {
+    reactor_.wake();
+  }
+}
+
+void Scheduler::wakeAll() {
+  epoch_.fetch_add(1);
+  epoch_.notify_all();
+  reactor_.wake();
+}
+
+void Scheduler::run(Worker& w) {
+  current_ = &w;
+  currentScheduler_ = this;
+  while (!stopped_.load(std::memory_order_acquire)) {
+    // a suspended task is only queued again by whoever resumes it:
+    // suspend() defers it at once, a FIFO awaiter once the FIFO is ready,
+    // the reactor once its event fired
+    if (auto h = next(w)) {
+      record(w, h);
+      h.resume();
+      continue;
+    }
+    park(w);
+  }
+  current_ = nullptr;
+  currentScheduler_ = nullptr;
+}
+
+std::coroutine_handle<> Scheduler::next(Worker& w) {
+  if (++w.ticks % kInjectInterval == 0) {
+    // the timers expire and the descriptors get ready while all are busy
+    if (tryPoll(w)) {
+      pushFired(w);
+    }
+    for (size_t level = 0; level < kPriorities; ++level) {
+      if (auto h = popInjected(w, level)) {
+        return h;
+      }
+    }
+  }
+  if (auto h = popLocal(w)) {
+    return h;
+  }
+  return steal(w);
+}
+
+std::coroutine_handle<> Scheduler::popLocal(Worker& w) {
+  if (w.lifo) {
+    auto level = levelOf(w.lifo);
+    auto higher = false;
+    for (size_t above = 0; above < level; ++above) {
+      higher = higher || hasWork(w, above);
+    }
+    if (w.lifoRuns < kLifoLimit && !higher) {
+      ++w.lifoRuns;
+      return std::exchange(w.lifo, nullptr);
+    }
+    pushLocal(w, std::exchange(w.lifo, nullptr));
+  }
+  w.lifoRuns = 0;
+  // the injection queue of the level counts as local work: an order posted
+  // from outside does not wait kInjectInterval runs behind bulk work
+  for (int level; (level = pickLevel(w)) >= 0;) {
+    void* address;
+    if (w.deques[level].pop(address)) {
+      return std::coroutine_handle<>::from_address(address);
+    }
+    if (auto h = popInjected(w, level)) {
+      return h;
+    }
+    // the deferred coroutines of a level run once the rest of its work is
+    // done, oldest first
+    auto& deferred = w.deferred[level];
+    if (!deferred.empty()) {
+      auto h = deferred.front();
+      for (auto it = deferred.rbegin(); it + 1 != deferred.rend(); ++it) {
+        pushLocal(w, *it);
+      }
+      deferred.clear();
+      return h;
+    }
+  }
+  return nullptr;
+}
+
+// the highest level with work, or a lower one which waited kAgingLimit
+// picks. -1 if there is no work at all
+int Scheduler::pickLevel(Worker& w) {
+  std::array<bool, kPriorities> work;
+  for (size_t level = 0; level < kPriorities; ++level) {
+    work[level] = hasWork(w, level);
+  }
+  int pick = -1;
+  for (size_t level = 1; level < kPriorities && pick < 0; ++level) {
+    if (work[level] && w.passed[level] >= kAgingLimit) {
+      pick = static_cast<int>(level);
+    }
+  }
+  for (size_t level = 0; level < kPriorities && pick < 0; ++level) {
+    if (work[level]) {
+      pick = static_cast<int>(level);
+    }
+  }
+  if (pick < 0) {
+    return pick;
+  }
+  w.passed[pick] = 0;
+  for (size_t level = pick + 1; level < kPriorities; ++level) {
+    w.passed[level] += work[level] ? 1 : 0;
+  }
+  return pick;
+}
+
+bool Scheduler::hasWork(const Worker& w, size_t level) const {
+  return !w.deques[level].empty() || !w.deferred[level].empty() ||
+         injectedSize_[level].load(std::memory_order_relaxed) != 0;
+}
+
+std::coroutine_handle<> Scheduler::popInjected(Worker& w, size_t level) {
+  if (injectedSize_[level].load(std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+  std::coroutine_handle<> h;
+  std::vector<std::coroutine_handle<>> batch;
+  {
+    std::unique_lock lock{injectMu_};
+    auto& injected = injected_[level];
+    if (injected.empty()) {
+      return nullptr;
+    }
+    h = injected.front();
+    injected.pop_front();
+    // a fair share of the rest, the others steal it from us if too much
+    auto n = std::min(kInjectBatch, injected.size() / workers_.size());
+    batch.assign(injected.begin(), injected.begin() + n);
+    injected.erase(injected.begin(), injected.begin() + n);
+    injectedSize_[level].store(injected.size(), std::memory_order_relaxed);
+  }
+  for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+    pushLocal(w, *it);
+  }
+  return h;
+}
+
+std::coroutine_handle<> Scheduler::steal(Worker& w) {
+  auto n = workers_.size();
+  if (n == 1) {
+    return nullptr;
+  }
+  searching_.fetch_add(1, std::memory_order_seq_cst);
+  // xorshift: a random first victim, then all of them in turn
+  w.rng ^= w.rng << 13;
+  w.rng ^= w.rng >> 7;
+  w.rng ^= w.rng << 17;
+  auto start = w.rng % n;
+  std::coroutine_handle<> h;
+  for (size_t level = 0; level < kPriorities && !h; ++level) {
+    for (size_t i = 0; i < n && !h; ++i) {
+      auto& victim = *workers_[(start + i) % n];
+      void* address;
+      if (&victim != &w && victim.deques[level].steal(address)) {
+        h = std::coroutine_handle<>::from_address(address);
+      }
+    }
+  }
+  // the last searcher to find work hands the search over, so that the rest
+  // of the victim's deque gets spread too
+  if (searching_.fetch_sub(1, std::memory_order_seq_cst) == 1 && h) {
+    notify();
+  }
+  return h;
+}
+
+bool Scheduler::hasWork() const {
+  for (size_t level = 0; level < kPriorities; ++level) {
+    if (injectedSize_[level].load(std::memory_order_relaxed) != 0) {
+      return true;
+    }
+    for (auto& worker : workers_) {
+      if (!worker->deques[level].empty()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// a worker which finds the reactor free blocks in it, until an event fired
+// or notify() wakes it through the eventfd
+void Scheduler::park(Worker& w) {
+  if (!polling_.load(std::memory_order_relaxed) &&
+      !polling_.exchange(true, std::memory_order_acquire)) {
+    pollerBlocked_.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto block = !hasWork() && !stopped_.load(std::memory_order_acquire);
+    reactor_.poll(block ? -1 : 0, w.fired);
+    pollerBlocked_.store(false, std::memory_order_relaxed);
+    releaseReactor();
+    pushFired(w);
+    return;
+  }
+  auto epoch = epoch_.load(std::memory_order_acquire);
+  sleepers_.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // a reactor released meanwhile is taken on the next park()
+  if (!hasWork() && !stopped_.load(std::memory_order_acquire) &&
+      polling_.load(std::memory_order_relaxed)) {
+    epoch_.wait(epoch, std::memory_order_acquire);
+  }
+  sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// the fence pairs with the one of park(): either a worker parking meanwhile
+// sees the reactor free and takes it over, or we see it asleep and wake it
+// to do so. the timers and descriptors do not wait for the next poll of a
+// busy worker while one is idle
+void Scheduler::releaseReactor() {
+  polling_.store(false, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_relaxed) != 0) {
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_one();
+  }
+}
+
+bool Scheduler::tryPoll(Worker& w) {
+  if (polling_.load(std::memory_order_relaxed) ||
+      polling_.exchange(true, std::memory_order_acquire)) {
+    return false;
+  }
+  reactor_.poll(0, w.fired);
+  releaseReactor();
+  return true;
+}
+
+// oldest first, the others may steal them
+void Scheduler::pushFired(Worker& w) {
+  for (auto it = w.fired.rbegin(); it != w.fired.rend(); ++it) {
+    stamp(*it);
+    pushLocal(w, *it);
+  }
+  w.fired.clear();
 }
 
 #endif  // SCHEDULER_HPP_
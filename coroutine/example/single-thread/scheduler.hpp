@@ -1,20 +1,47 @@
 #ifndef SCHEDULER_HPP_
 #define SCHEDULER_HPP_
 
+#include <array>
+#include <condition_variable>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <queue>
 #include <stack>
 
+#include "../../cppcoro/include/cppcoro/frame_pool.hpp"
+
+// the run queue a task waits in. the higher levels run first, but a lower
+// level with work which was passed over kAgingLimit times gets the next turn
+enum class Priority : std::uint8_t { kHigh, kNormal, kLow };
+inline constexpr size_t kPriorities = 3;
+
+class Scheduler;
+
 struct Task {
-  struct promise_type {
+  struct promise_type;
+  // a parked task may be resumed by the thread which unparks it and end
+  // there: it reports its end itself
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  // the frames come from the thread-local free lists of the frame pool
+  struct promise_type : coro::pooled_frame {
     std::suspend_always initial_suspend() noexcept { return {}; }
-    std::suspend_always final_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
 
     void unhandled_exception() { ; }
     void return_void() {}
     Task get_return_object() noexcept {
       return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
     }
+
+    Scheduler* scheduler = nullptr;
+    Priority priority = Priority::kNormal;
   };
 
   auto get_handle() noexcept -> std::coroutine_handle<promise_type> {
@@ -24,32 +51,130 @@ struct Task {
 };
 
 
+// runs the tasks on the thread calling run(). post() may come from any
+// thread, e.g. from the producer which unparks a task waiting on a FIFO
 class Scheduler {
 public: 
-  void add_task(std::coroutine_handle<> h)  {
-    task_.push(h);
+  void add_task(std::coroutine_handle<Task::promise_type> h,
+                Priority priority = Priority::kNormal) {
+    h.promise().scheduler = this;
+    h.promise().priority = priority;
+    std::unique_lock lock{mutex_};
+    ++outstanding_;
+    push(h);
+  }
+
+  // make a suspended task runnable again, from any thread, e.g. from the
+  // awaiter which parked it. h has to be the handle of a Task: its priority
+  // is in the promise
+  void post(std::coroutine_handle<> h) {
+    std::unique_lock lock{mutex_};
+    push(h);
   }
 
+  // a suspended task is only queued again by whoever resumes it: suspend()
+  // queues it at once, a FIFO awaiter once the FIFO is ready. returns once
+  // every task added ended, waiting for the parked ones to be posted
   void run() {
-    while (!task_.empty()) {
-      auto t = task_.front();
-      task_.pop();
-      t.resume();
-      if (t.done()) {
-        t.destroy();
-      } else {
-        add_task(t);
+    std::unique_lock lock{mutex_};
+    while (outstanding_ != 0) {
+      auto level = pickLevel();
+      if (level < 0) {
+        ready_.wait(lock);
+        continue;
       }
+      auto t = task_[level].front();
+      task_[level].pop();
+      lock.unlock();
+      t.resume();
+      lock.lock();
     }
   }
 
-  auto suspend() -> std::suspend_always {
-    return {};
+  // the running task is queued with priority from its next suspension on
+  struct SetPriority {
+    Priority priority;
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<Task::promise_type> h) noexcept {
+      h.promise().priority = priority;
+      return false;
+    }
+    void await_resume() const noexcept {}
+  };
+  auto set_priority(Priority priority) -> SetPriority {
+    return {priority};
+  }
+
+  struct Suspend {
+    Scheduler& sch;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { sch.post(h); }
+    void await_resume() const noexcept {}
+  };
+  auto yield() -> Suspend {
+    return {*this};
+  }
+  auto suspend() -> Suspend {
+    return {*this};
   }
 private:
-  std::queue<std::coroutine_handle<>> task_;
+  friend struct Task::FinalAwaiter;
+  static constexpr int kAgingLimit = 8;
+
+  // under mutex_
+  void push(std::coroutine_handle<> h) {
+    auto task = std::coroutine_handle<Task::promise_type>::from_address(
+        h.address());
+    task_[static_cast<size_t>(task.promise().priority)].push(h);
+    ready_.notify_one();
+  }
+  void finished() {
+    std::unique_lock lock{mutex_};
+    if (--outstanding_ == 0) {
+      ready_.notify_one();
+    }
+  }
 
+  // the highest level with work, or a lower one which waited kAgingLimit
+  // picks. -1 once there is no work left
+  int pickLevel() {
+    int pick = -1;
+    for (size_t level = 1; level < kPriorities && pick < 0; ++level) {
+      if (!task_[level].empty() && passed_[level] >= kAgingLimit) {
+        pick = static_cast<int>(level);
+      }
+    }
+    for (size_t level = 0; level < kPriorities && pick < 0; ++level) {
+      if (!task_[level].empty()) {
+        pick = static_cast<int>(level);
+      }
+    }
+    if (pick < 0) {
+      return pick;
+    }
+    passed_[pick] = 0;
+    for (size_t level = pick + 1; level < kPriorities; ++level) {
+      passed_[level] += task_[level].empty() ? 0 : 1;
+    }
+    return pick;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::array<std::queue<std::coroutine_handle<>>, kPriorities> task_;
+  std::array<int, kPriorities> passed_{};
+  // tasks added and not ended yet
+  size_t outstanding_ = 0;
 };
 
+inline void Task::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept {
+  auto scheduler = h.promise().scheduler;
+  h.destroy();
+  if (scheduler != nullptr) {
+    scheduler->finished();
+  }
+}
+
 
 #endif  // SCHEDULER_HPP_
@@ -0,0 +1,600 @@
+#ifndef UTILITY_BASIC_FIFO_HPP_
+#define UTILITY_BASIC_FIFO_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "bulk_copy.hpp"
+#include "capacity.hpp"
+#include "coroutine_wait.hpp"
+#include "cursor.hpp"
+#include "stats.hpp"
+#include "wait.hpp"
+
+// the policies of BasicFifo which are only switches or values, the others
+// are the cursor (cursor.hpp), capacity (capacity.hpp), wait (wait.hpp,
+// coroutine_wait.hpp) and stats (stats.hpp) policies
+
+// the ring storage comes from Alloc, std::allocator<Tp> by default
+template <class Alloc>
+struct WithAllocator {
+  using allocator_type = Alloc;
+};
+// each cursor on its own cache line
+template <bool On>
+struct Padding {
+  static constexpr bool kPadded = On;
+};
+using Padded = Padding<true>;
+// each side keeps a copy of the cursor of the other side and only reloads
+// it when the ring looks full or empty
+template <bool On>
+struct Caching {
+  static constexpr bool kCached = On;
+};
+using CachedCursors = Caching<true>;
+// push_n/pop_n
+template <bool On>
+struct Batching {
+  static constexpr bool kBatched = On;
+};
+using Batched = Batching<true>;
+// publish the cursors every K elements, needs CachedCursors
+template <std::size_t K>
+struct LazyCommit {
+  static constexpr std::size_t kCommitEvery = K;
+};
+
+namespace detail {
+template <class P>
+struct IsAllocatorPolicy
+    : std::bool_constant<requires { typename P::allocator_type; }> {};
+template <class P>
+struct IsCapacityPolicy
+    : std::bool_constant<requires(const P& p, std::size_t cursor) {
+        p.capacity();
+        p.index(cursor);
+      }> {};
+template <class P>
+struct IsCursorPolicy : std::bool_constant<requires {
+  typename P::template cursor_type<std::size_t>;
+}> {};
+template <class P>
+struct IsPaddingPolicy : std::bool_constant<requires { P::kPadded; }> {};
+template <class P>
+struct IsCachingPolicy : std::bool_constant<requires { P::kCached; }> {};
+template <class P>
+struct IsBatchingPolicy : std::bool_constant<requires { P::kBatched; }> {};
+template <class P>
+struct IsCommitPolicy : std::bool_constant<requires { P::kCommitEvery; }> {};
+template <class P>
+struct IsWaitPolicy : std::bool_constant<requires { P::kBlocking; }> {};
+template <class P>
+struct IsStatsPolicy : std::bool_constant<requires { P::kEnabled; }> {};
+
+template <class P>
+inline constexpr int kPolicyKinds =
+    IsAllocatorPolicy<P>::value + IsCapacityPolicy<P>::value +
+    IsCursorPolicy<P>::value + IsPaddingPolicy<P>::value +
+    IsCachingPolicy<P>::value + IsBatchingPolicy<P>::value +
+    IsCommitPolicy<P>::value + IsWaitPolicy<P>::value +
+    IsStatsPolicy<P>::value;
+
+// the first of Policies which satisfies Is, Default if none does
+template <template <class> class Is, class Default, class... Policies>
+struct PickPolicy {
+  using type = Default;
+};
+template <template <class> class Is,
+          class Default,
+          class Policy,
+          class... Policies>
+struct PickPolicy<Is, Default, Policy, Policies...> {
+  using type =
+      std::conditional_t<Is<Policy>::value,
+                         Policy,
+                         typename PickPolicy<Is, Default, Policies...>::type>;
+};
+
+template <class Tp, class... Policies>
+struct FifoPolicies {
+  static_assert(((kPolicyKinds<Policies> == 1) && ...),
+                "every policy of BasicFifo should be of exactly one kind");
+
+  using allocator_type =
+      typename PickPolicy<IsAllocatorPolicy,
+                          WithAllocator<std::allocator<Tp>>,
+                          Policies...>::type::allocator_type;
+  using capacity =
+      typename PickPolicy<IsCapacityPolicy, PowerOfTwoCapacity, Policies...>::
+          type;
+  using cursor =
+      typename PickPolicy<IsCursorPolicy, AcqRelCursors, Policies...>::type;
+  using wait = typename PickPolicy<IsWaitPolicy, NoWait, Policies...>::type;
+  using stats = typename PickPolicy<IsStatsPolicy, NoStats, Policies...>::type;
+  static constexpr bool kPadded =
+      PickPolicy<IsPaddingPolicy, Padding<false>, Policies...>::type::kPadded;
+  static constexpr bool kCached =
+      PickPolicy<IsCachingPolicy, Caching<false>, Policies...>::type::kCached;
+  static constexpr bool kBatched =
+      PickPolicy<IsBatchingPolicy, Batching<false>, Policies...>::type::
+          kBatched;
+  static constexpr std::size_t kCommitEvery =
+      PickPolicy<IsCommitPolicy, LazyCommit<1>, Policies...>::type::
+          kCommitEvery;
+};
+
+// takes the place of a member a policy does without
+template <int Tag>
+struct NoCursor {};
+}  // namespace detail
+
+// single producer single consumer circular FIFO whose cursors, layout and
+// features are picked at compile time by Policies, in any order:
+//   WithAllocator<Alloc>                 std::allocator<Tp>
+//   capacity policy                      PowerOfTwoCapacity
+//   cursor policy                        AcqRelCursors
+//   Padding<bool>                        not padded
+//   Caching<bool>                        not cached
+//   Batching<bool>                       no push_n/pop_n
+//   LazyCommit<K>                        LazyCommit<1>
+//   wait policy                          NoWait
+//   stats policy                         NoStats
+// Fifo1 to Fifo4 are aliases of it.
+//
+// LazyCommit<K> with K > 1 publishes the cursors lazily: the producer
+// publishes pushCursor_ every K elements or when the ring looks full, the
+// consumer publishes popCursor_ every K elements or when the ring looks
+// drained. the producer has to flush_push() at the points where the
+// consumer must see everything pushed so far
+//
+// FifoStats counts the full/empty stalls and the cached cursor refreshes,
+// see counters()
+template <class Tp, class... Policies>
+class BasicFifo
+    : private detail::FifoPolicies<Tp, Policies...>::allocator_type {
+  using policies = detail::FifoPolicies<Tp, Policies...>;
+  using Alloc = typename policies::allocator_type;
+  using Capacity = typename policies::capacity;
+  using Cursor = typename policies::cursor;
+  using Wait = typename policies::wait;
+  using Stats = typename policies::stats;
+  static constexpr bool kPadded = policies::kPadded;
+  static constexpr bool kCached = policies::kCached;
+  static constexpr bool kBatched = policies::kBatched;
+  static constexpr std::size_t kCommitEvery = policies::kCommitEvery;
+  static constexpr bool kLazyCommit = kCommitEvery > 1;
+  static_assert(!kLazyCommit || kCached,
+                "LazyCommit decides when to publish from the cached cursors");
+
+ public:
+  using value_type = Tp;
+  using pointer_type = Tp*;
+  using allocator_type = Alloc;
+  using allocator_traits = std::allocator_traits<Alloc>;
+  using size_type = typename allocator_traits::size_type;
+  explicit BasicFifo(size_type sz, const Alloc& alloc = Alloc{})
+      : Alloc(alloc),
+        capacity_(sz),
+        ring_(allocator_traits::allocate(*this, capacity_.capacity())) {}
+  BasicFifo(const BasicFifo&) = delete;
+  BasicFifo& operator=(const BasicFifo&) = delete;
+
+  BasicFifo(BasicFifo&&) = delete;
+  BasicFifo& operator=(BasicFifo&&) = delete;
+
+  ~BasicFifo() {
+    flush_push();
+    flush_pop();
+    auto popIdx = Cursor::loadOwn(popCursor_);
+    auto pushIdx = Cursor::loadOwn(pushCursor_);
+    for (; popIdx != pushIdx; ++popIdx) {
+      ring_[capacity_.index(popIdx)].~Tp();
+    }
+    allocator_traits::deallocate(*this, ring_, capacity_.capacity());
+  }
+  auto size() const noexcept {
+    auto popIdx = Cursor::loadOther(popCursor_);
+    auto pushIdx = Cursor::loadOther(pushCursor_);
+    assert(popIdx <= pushIdx);
+    return pushIdx - popIdx;
+  }
+  auto full() const noexcept { return size() == capacity_.capacity(); }
+  auto empty() const noexcept { return size() == 0; }
+  // only available with FifoStats, may be called from any thread
+  FifoCounters counters() const noexcept requires Stats::kEnabled {
+    return stats_.counters();
+  }
+
+  auto push(const Tp& value) { return emplace(value); }
+  auto push(Tp&& value) { return emplace(std::move(value)); }
+  template <class... Args>
+  auto emplace(Args&&... args) {
+    auto pushIdx = localPushCursor();
+    if (!canPush(pushIdx)) {
+      return false;
+    }
+    ::new (&ring_[capacity_.index(pushIdx)]) Tp(std::forward<Args>(args)...);
+    advancePushCursor(pushIdx, pushIdx + 1);
+    return true;
+  }
+  auto pop(value_type& value) {
+    auto popIdx = localPopCursor();
+    if (!canPop(popIdx)) {
+      return false;
+    }
+    auto& slot = ring_[capacity_.index(popIdx)];
+    value = std::move(slot);
+    slot.~Tp();
+    advancePopCursor(popIdx, popIdx + 1);
+    return true;
+  }
+  // move the oldest element out, std::nullopt if empty
+  auto pop() -> std::optional<Tp> {
+    auto slot = front();
+    if (slot == nullptr) {
+      return std::nullopt;
+    }
+    std::optional<Tp> value{std::move(*slot)};
+    release();
+    return value;
+  }
+  // invoke consumer(Tp&) on the oldest element in place, then destroy it.
+  // return false if empty
+  template <class F>
+  auto try_pop(F&& consumer) -> bool
+    requires std::is_invocable_v<F, Tp&>
+  {
+    auto slot = front();
+    if (slot == nullptr) {
+      return false;
+    }
+    std::forward<F>(consumer)(*slot);
+    release();
+    return true;
+  }
+
+  // blocking push/pop, only available with a blocking Wait policy such as
+  // FutexWait. the timed variants return false on timeout
+  void push_wait(const Tp& value) requires Wait::kBlocking {
+    while (!push(value)) {
+      wait_.waitProducer([this] { return reserve() != nullptr; },
+                         Wait::clock::time_point::max());
+    }
+  }
+  template <class Rep, class Period>
+  bool push_wait_for(const Tp& value,
+                     const std::chrono::duration<Rep, Period>& timeout)
+    requires Wait::kBlocking
+  {
+    return wait_.waitProducer([this] { return reserve() != nullptr; },
+                              Wait::clock::now() + timeout) &&
+           push(value);
+  }
+  void pop_wait(value_type& value) requires Wait::kBlocking {
+    while (!pop(value)) {
+      wait_.waitConsumer([this] { return front() != nullptr; },
+                         Wait::clock::time_point::max());
+    }
+  }
+  template <class Rep, class Period>
+  bool pop_wait_for(value_type& value,
+                    const std::chrono::duration<Rep, Period>& timeout)
+    requires Wait::kBlocking
+  {
+    return wait_.waitConsumer([this] { return front() != nullptr; },
+                              Wait::clock::now() + timeout) &&
+           pop(value);
+  }
+
+  // awaitable push/pop, only available with CoroutineWait. co_await
+  // async_pop() parks the coroutine while the ring is empty, the producer
+  // resumes it on its own thread or through executor.post(handle) once it
+  // pushed. one coroutine per side awaits at a time
+  template <class Executor = InlineResume>
+  auto async_pop(Executor& executor = inlineResume) requires Wait::kAsync {
+    return detail::PopAwaiter<BasicFifo, Executor>{*this, wait_, executor};
+  }
+  template <class Executor = InlineResume>
+  auto async_push(Tp value, Executor& executor = inlineResume)
+    requires Wait::kAsync
+  {
+    return detail::PushAwaiter<BasicFifo, Executor>{*this, wait_, executor,
+                                                    std::move(value)};
+  }
+
+  // zero-copy producer: return the uninitialized storage of the next slot or
+  // nullptr if full, the caller constructs the element in place and then
+  // publishes it with commit()
+  pointer_type reserve() {
+    auto pushIdx = localPushCursor();
+    if (!canPush(pushIdx)) {
+      return nullptr;
+    }
+    return &ring_[capacity_.index(pushIdx)];
+  }
+  void commit() {
+    auto pushIdx = localPushCursor();
+    advancePushCursor(pushIdx, pushIdx + 1);
+  }
+
+  // zero-copy consumer: return the oldest element or nullptr if empty, the
+  // element stays valid until release() destroys it
+  pointer_type front() {
+    auto popIdx = localPopCursor();
+    if (!canPop(popIdx)) {
+      return nullptr;
+    }
+    return &ring_[capacity_.index(popIdx)];
+  }
+  void release() {
+    auto popIdx = localPopCursor();
+    ring_[capacity_.index(popIdx)].~Tp();
+    advancePopCursor(popIdx, popIdx + 1);
+  }
+
+  // push as many elements of [first, last) as there are free slots, the
+  // pushCursor_ is published once for the whole batch.
+  // return the number of elements pushed
+  template <class ForwardIt>
+  size_type push_n(ForwardIt first, ForwardIt last) requires kBatched {
+    auto pushIdx = localPushCursor();
+    auto popIdx = knownPopCursor();
+    auto want = static_cast<size_type>(std::distance(first, last));
+    if (available(popIdx, pushIdx) < want) {
+      popIdx = refreshPopCursor(popIdx);
+    }
+    auto n = std::min(want, available(popIdx, pushIdx));
+    if (n == 0) {
+      stats_.pushFull();
+      return 0;
+    }
+    stats_.pushed(pushIdx + n - popIdx);
+    if constexpr (kBulkCopy<ForwardIt>) {
+      copyIn(pushIdx, std::to_address(first), n);
+    } else {
+      for (size_type i = 0; i < n; ++i, ++first) {
+        ::new (&ring_[capacity_.index(pushIdx + i)]) Tp(*first);
+      }
+    }
+    advancePushCursor(pushIdx, pushIdx + n);
+    return n;
+  }
+  // return the part of values which is not pushed
+  auto push_n(std::span<const Tp> values)
+      -> std::span<const Tp> requires kBatched {
+    return values.subspan(push_n(values.begin(), values.end()));
+  }
+
+  // pop at most max elements into out, the popCursor_ is published once for
+  // the whole batch.
+  // return the number of elements popped
+  template <class OutputIt>
+  size_type pop_n(OutputIt out, size_type max) requires kBatched {
+    auto popIdx = localPopCursor();
+    auto pushIdx = knownPushCursor();
+    if (pushIdx - popIdx < max) {
+      pushIdx = refreshPushCursor(pushIdx);
+    }
+    auto n = std::min(max, pushIdx - popIdx);
+    if (n == 0) {
+      stats_.popEmpty();
+      return 0;
+    }
+    if constexpr (kBulkCopy<OutputIt>) {
+      copyOut(popIdx, std::to_address(out), n);
+    } else {
+      for (size_type i = 0; i < n; ++i, ++out) {
+        auto& slot = ring_[capacity_.index(popIdx + i)];
+        *out = std::move(slot);
+        slot.~Tp();
+      }
+    }
+    advancePopCursor(popIdx, popIdx + n);
+    return n;
+  }
+  // return the filled prefix of values
+  auto pop_n(std::span<Tp> values) -> std::span<Tp> requires kBatched {
+    return values.first(pop_n(values.begin(), values.size()));
+  }
+
+  // publish the elements pushed so far, producer side only
+  void flush_push() {
+    if constexpr (kLazyCommit) {
+      auto published = Cursor::loadOwn(pushCursor_);
+      if (localPushCursor_ != published) {
+        Cursor::publish(pushCursor_, published, localPushCursor_);
+        wait_.notifyConsumer();
+      }
+    }
+  }
+  // publish the elements popped so far, consumer side only
+  void flush_pop() {
+    if constexpr (kLazyCommit) {
+      auto published = Cursor::loadOwn(popCursor_);
+      if (localPopCursor_ != published) {
+        Cursor::publish(popCursor_, published, localPopCursor_);
+        wait_.notifyProducer();
+      }
+    }
+  }
+
+ private:
+  auto full(size_type popIdx, size_type pushIdx) {
+    // assert(popIdx <= pushIdx);
+    return (pushIdx - popIdx) == capacity_.capacity();
+  }
+  auto empty(size_type popIdx, size_type pushIdx) {
+    // assert(popIdx <= pushIdx);
+    return (pushIdx - popIdx) == 0;
+  }
+  auto available(size_type popIdx, size_type pushIdx) {
+    return capacity_.capacity() - (pushIdx - popIdx);
+  }
+
+  // the cursor of the other side as known without touching its cache line
+  // when cached, a fresh load otherwise
+  size_type knownPopCursor() const noexcept {
+    if constexpr (kCached) {
+      return cachedPopCursor_;
+    } else {
+      return Cursor::loadOther(popCursor_);
+    }
+  }
+  size_type knownPushCursor() const noexcept {
+    if constexpr (kCached) {
+      return cachedPushCursor_;
+    } else {
+      return Cursor::loadOther(pushCursor_);
+    }
+  }
+  // reload the cursor of the other side once the known one is not enough,
+  // without caching known was just loaded
+  size_type refreshPopCursor(size_type known) {
+    if constexpr (kCached) {
+      cachedPopCursor_ = Cursor::loadOther(popCursor_);
+      stats_.popCursorRefresh();
+      return cachedPopCursor_;
+    } else {
+      return known;
+    }
+  }
+  size_type refreshPushCursor(size_type known) {
+    if constexpr (kCached) {
+      cachedPushCursor_ = Cursor::loadOther(pushCursor_);
+      stats_.pushCursorRefresh();
+      return cachedPushCursor_;
+    } else {
+      return known;
+    }
+  }
+
+  // whether the slot at pushIdx is free, resp. the slot at popIdx is filled
+  bool canPush(size_type pushIdx) {
+    auto popIdx = knownPopCursor();
+    if (full(popIdx, pushIdx)) {
+      popIdx = refreshPopCursor(popIdx);
+      if (full(popIdx, pushIdx)) {
+        stats_.pushFull();
+        return false;
+      }
+    }
+    stats_.pushed(pushIdx + 1 - popIdx);
+    return true;
+  }
+  bool canPop(size_type popIdx) {
+    auto pushIdx = knownPushCursor();
+    if (empty(popIdx, pushIdx)) {
+      pushIdx = refreshPushCursor(pushIdx);
+      if (empty(popIdx, pushIdx)) {
+        stats_.popEmpty();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // a batch between contiguous Tp and a trivially copyable ring is copied
+  // with bulkCopy(), in at most two runs because of the wrap around. a large
+  // batch is pushed with bulkStream(): the consumer reads it, not us
+  template <class It>
+  static constexpr bool kBulkCopy =
+      std::is_trivially_copyable_v<Tp> && std::contiguous_iterator<It> &&
+      std::is_same_v<std::remove_cv_t<std::iter_value_t<It>>, Tp>;
+  void copyIn(size_type pushIdx, const Tp* first, size_type n) {
+    auto offset = capacity_.index(pushIdx);
+    auto head = std::min(n, capacity_.capacity() - offset);
+    auto copy = n * sizeof(Tp) < kNonTemporalThreshold ? bulkCopy : bulkStream;
+    copy(&ring_[offset], first, head * sizeof(Tp));
+    copy(ring_, first + head, (n - head) * sizeof(Tp));
+  }
+  void copyOut(size_type popIdx, Tp* out, size_type n) {
+    auto offset = capacity_.index(popIdx);
+    auto head = std::min(n, capacity_.capacity() - offset);
+    bulkCopy(out, &ring_[offset], head * sizeof(Tp));
+    bulkCopy(out + head, ring_, (n - head) * sizeof(Tp));
+  }
+
+  // the cursors as seen by their owner, ahead of the published ones by the
+  // elements not committed yet
+  size_type localPushCursor() const noexcept {
+    if constexpr (kLazyCommit) {
+      return localPushCursor_;
+    } else {
+      return Cursor::loadOwn(pushCursor_);
+    }
+  }
+  size_type localPopCursor() const noexcept {
+    if constexpr (kLazyCommit) {
+      return localPopCursor_;
+    } else {
+      return Cursor::loadOwn(popCursor_);
+    }
+  }
+  void advancePushCursor(size_type from, size_type pushIdx) {
+    if constexpr (kLazyCommit) {
+      localPushCursor_ = pushIdx;
+      from = Cursor::loadOwn(pushCursor_);
+      // a full ring must be published or the consumer never drains it
+      if (pushIdx - from < kCommitEvery && !full(cachedPopCursor_, pushIdx)) {
+        return;
+      }
+    }
+    Cursor::publish(pushCursor_, from, pushIdx);
+    wait_.notifyConsumer();
+  }
+  void advancePopCursor(size_type from, size_type popIdx) {
+    if constexpr (kLazyCommit) {
+      localPopCursor_ = popIdx;
+      from = Cursor::loadOwn(popCursor_);
+      // a drained ring must be published or the producer never refills it
+      if (popIdx - from < kCommitEvery && !empty(popIdx, cachedPushCursor_)) {
+        return;
+      }
+    }
+    Cursor::publish(popCursor_, from, popIdx);
+    wait_.notifyProducer();
+  }
+
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  using cursor_type = typename Cursor::template cursor_type<size_type>;
+  static_assert(!std::is_same_v<cursor_type, std::atomic<size_type>> ||
+                    std::atomic<size_type>::is_always_lock_free,
+                "size_type should lock-free");
+  template <int Tag>
+  using cached_type =
+      std::conditional_t<kCached, size_type, detail::NoCursor<Tag>>;
+  template <int Tag>
+  using local_type =
+      std::conditional_t<kLazyCommit, size_type, detail::NoCursor<Tag>>;
+  static constexpr size_t kCursorAlign =
+      kPadded ? hardware_destructive_interference_size : alignof(cursor_type);
+  static constexpr size_t kCachedAlign =
+      kPadded && kCached ? hardware_destructive_interference_size
+                         : alignof(cached_type<0>);
+
+  [[no_unique_address]] Capacity capacity_;
+  pointer_type ring_;
+  // each shared cursor, then the private cursors of the side which reads it
+  alignas(kCursorAlign) cursor_type pushCursor_{};
+  alignas(kCachedAlign) [[no_unique_address]] cached_type<0>
+      cachedPushCursor_{};
+  [[no_unique_address]] local_type<1> localPopCursor_{};
+  alignas(kCursorAlign) cursor_type popCursor_{};
+  alignas(kCachedAlign) [[no_unique_address]] cached_type<2>
+      cachedPopCursor_{};
+  [[no_unique_address]] local_type<3> localPushCursor_{};
+  [[no_unique_address]] Wait wait_;
+  [[no_unique_address]] Stats stats_;
+};
+
+#endif  // UTILITY_BASIC_FIFO_HPP_
@@ -0,0 +1,182 @@
+#ifndef UTILITY_BULK_COPY_HPP_
+#define UTILITY_BULK_COPY_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// copy of trivially copyable batches into and out of the rings with the
+// widest vector unit of the cpu, picked once at runtime: AVX-512, AVX2 or
+// memcpy. bulkStream() stores bypassing the cache: the producer writes a
+// batch of kNonTemporalThreshold bytes or more into the ring with it, such
+// a batch would only evict its working set. the consumer copies out with
+// bulkCopy(), it is about to use the data.
+//
+// FIFO_BULK_COPY=scalar|avx2|avx512 in the environment forces an
+// implementation (an unsupported one falls back to the best supported)
+
+// batches pushed from this size on use non-temporal stores
+inline constexpr std::size_t kNonTemporalThreshold = 128 * 1024;
+
+namespace detail {
+using bulk_copy_fn = void (*)(std::byte*, const std::byte*, std::size_t);
+
+struct BulkCopyImpl {
+  const char* name;
+  bulk_copy_fn copy;
+  bulk_copy_fn stream;
+};
+
+inline void scalarCopy(std::byte* dst, const std::byte* src, std::size_t n) {
+  std::memcpy(dst, src, n);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) inline void avx2Copy(std::byte* dst,
+                                                     const std::byte* src,
+                                                     std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 128 <= n; i += 128) {
+    auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    auto b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+    auto c =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 64));
+    auto d =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 96));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), a);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 32), b);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 64), c);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 96), d);
+  }
+  for (; i + 32 <= n; i += 32) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+  }
+  std::memcpy(dst + i, src + i, n - i);
+}
+__attribute__((target("avx2"))) inline void avx2Stream(std::byte* dst,
+                                                       const std::byte* src,
+                                                       std::size_t n) {
+  // cached stores up to the first 32 bytes aligned destination
+  auto head = std::min<std::size_t>(
+      n, (32 - reinterpret_cast<std::uintptr_t>(dst) % 32) % 32);
+  avx2Copy(dst, src, head);
+  std::size_t i = head;
+  for (; i + 32 <= n; i += 32) {
+    _mm256_stream_si256(
+        reinterpret_cast<__m256i*>(dst + i),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+  }
+  // the consumer must not see the cursor before the streamed data
+  _mm_sfence();
+  std::memcpy(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline void avx512Copy(
+    std::byte* dst,
+    const std::byte* src,
+    std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 256 <= n; i += 256) {
+    auto a = _mm512_loadu_si512(src + i);
+    auto b = _mm512_loadu_si512(src + i + 64);
+    auto c = _mm512_loadu_si512(src + i + 128);
+    auto d = _mm512_loadu_si512(src + i + 192);
+    _mm512_storeu_si512(dst + i, a);
+    _mm512_storeu_si512(dst + i + 64, b);
+    _mm512_storeu_si512(dst + i + 128, c);
+    _mm512_storeu_si512(dst + i + 192, d);
+  }
+  for (; i + 64 <= n; i += 64) {
+    _mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+  }
+  // the tail with one masked load/store
+  if (i != n) {
+    auto mask = _cvtu64_mask64((~std::uint64_t{0}) >> (64 - (n - i)));
+    auto tail = _mm512_maskz_loadu_epi8(mask, src + i);
+    _mm512_mask_storeu_epi8(dst + i, mask, tail);
+  }
+}
+__attribute__((target("avx512f,avx512bw"))) inline void avx512Stream(
+    std::byte* dst,
+    const std::byte* src,
+    std::size_t n) {
+  auto head = std::min<std::size_t>(
+      n, (64 - reinterpret_cast<std::uintptr_t>(dst) % 64) % 64);
+  avx512Copy(dst, src, head);
+  std::size_t i = head;
+  for (; i + 64 <= n; i += 64) {
+    _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + i),
+                        _mm512_loadu_si512(src + i));
+  }
+  _mm_sfence();
+  std::memcpy(dst + i, src + i, n - i);
+}
+#endif
+
+inline BulkCopyImpl selectBulkCopy() noexcept {
+  std::string_view forced;
+  if (auto env = std::getenv("FIFO_BULK_COPY")) {
+    forced = env;
+  }
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  auto avx512 = __builtin_cpu_supports("avx512f") &&
+                __builtin_cpu_supports("avx512bw");
+  auto avx2 = __builtin_cpu_supports("avx2");
+  if (avx512 && (forced.empty() || forced == "avx512")) {
+    return {"avx512", avx512Copy, avx512Stream};
+  }
+  if (avx2 && forced != "scalar") {
+    return {"avx2", avx2Copy, avx2Stream};
+  }
+#endif
+  return {"scalar", scalarCopy, scalarCopy};
+}
+
+inline const BulkCopyImpl& bulkCopyImpl() noexcept {
+  static const BulkCopyImpl impl = selectBulkCopy();
+  return impl;
+}
+}  // namespace detail
+
+// copy n bytes from src to dst, the ranges do not overlap
+inline void bulkCopy(void* dst, const void* src, std::size_t n) noexcept {
+  auto out = static_cast<std::byte*>(dst);
+  auto in = static_cast<const std::byte*>(src);
+  // not worth an indirect call
+  if (n < 64) {
+    std::memcpy(out, in, n);
+    return;
+  }
+  detail::bulkCopyImpl().copy(out, in, n);
+}
+
+// as bulkCopy(), with non-temporal stores: dst is not read back soon by
+// this thread
+inline void bulkStream(void* dst, const void* src, std::size_t n) noexcept {
+  auto out = static_cast<std::byte*>(dst);
+  auto in = static_cast<const std::byte*>(src);
+  if (n < 64) {
+    std::memcpy(out, in, n);
+    return;
+  }
+  detail::bulkCopyImpl().stream(out, in, n);
+}
+
+// the implementation picked by bulkCopy() and bulkStream(): "avx512",
+// "avx2" or "scalar"
+inline const char* bulkCopyIsa() noexcept {
+  return detail::bulkCopyImpl().name;
+}
+
+#endif  // UTILITY_BULK_COPY_HPP_
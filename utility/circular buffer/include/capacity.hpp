@@ -0,0 +1,52 @@
+#ifndef UTILITY_CAPACITY_HPP_
+#define UTILITY_CAPACITY_HPP_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+// capacity policies of the FIFOs: capacity() is the number of slots of the
+// ring and index() maps a monotonic cursor to its slot
+
+// the requested size is used as is, index by modulo (integer division)
+class ModuloCapacity {
+ public:
+  explicit ModuloCapacity(std::size_t sz) noexcept
+      : capacity_{std::max<std::size_t>(sz, 1)} {}
+  std::size_t capacity() const noexcept { return capacity_; }
+  std::size_t index(std::size_t cursor) const noexcept {
+    return cursor % capacity_;
+  }
+
+ private:
+  std::size_t capacity_;
+};
+
+// the requested size is rounded up to a power of two, index by mask
+class PowerOfTwoCapacity {
+ public:
+  explicit PowerOfTwoCapacity(std::size_t sz) noexcept
+      : mask_{std::bit_ceil(std::max<std::size_t>(sz, 1)) - 1} {}
+  std::size_t capacity() const noexcept { return mask_ + 1; }
+  std::size_t index(std::size_t cursor) const noexcept {
+    return cursor & mask_;
+  }
+
+ private:
+  std::size_t mask_;
+};
+
+// the capacity is fixed at compile time, the requested size is ignored
+template <std::size_t N>
+class FixedCapacity {
+  static_assert(std::has_single_bit(N), "capacity should be a power of two");
+
+ public:
+  constexpr explicit FixedCapacity(std::size_t) noexcept {}
+  static constexpr std::size_t capacity() noexcept { return N; }
+  static constexpr std::size_t index(std::size_t cursor) noexcept {
+    return cursor & (N - 1);
+  }
+};
+
+#endif  // UTILITY_CAPACITY_HPP_
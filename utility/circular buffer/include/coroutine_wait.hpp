@@ -0,0 +1,189 @@
+#ifndef UTILITY_COROUTINE_WAIT_HPP_
+#define UTILITY_COROUTINE_WAIT_HPP_
+
+#include <atomic>
+#include <coroutine>
+#include <optional>
+#include <utility>
+
+// waiting policy of the FIFOs for coroutines: async_pop()/async_push()
+// park the awaiting coroutine in a single waiter slot per side and the
+// notify hook of the other side resumes it, no thread ever blocks
+
+// the coroutine parked by one side: ready() tells whether the FIFO changed
+// enough to resume it, resume() resumes it (inline or through an executor,
+// with the handle type of the awaiting coroutine)
+struct CoroutineWaiter {
+  std::coroutine_handle<> handle;
+  bool (*ready)(const CoroutineWaiter&) noexcept;
+  void (*resume)(std::coroutine_handle<>, void* executor);
+  void* executor;
+};
+
+// resume the parked coroutine on the thread which unparks it
+struct InlineResume {
+  void post(std::coroutine_handle<> handle) { handle.resume(); }
+};
+inline InlineResume inlineResume;
+
+class CoroutineWait {
+ public:
+  static constexpr bool kBlocking = false;
+  static constexpr bool kAsync = true;
+
+  void notifyConsumer() noexcept { wake(consumerWaiter_); }
+  void notifyProducer() noexcept { wake(producerWaiter_); }
+
+  // park waiter unless ready() turns true meanwhile. return false if the
+  // caller has to retry at once, true if it stays suspended until notified.
+  // ready() must not touch waiter: once parked it may be resumed at any time
+  template <class Ready>
+  bool parkConsumer(CoroutineWaiter& waiter, Ready&& ready) noexcept {
+    return park(consumerWaiter_, waiter, ready);
+  }
+  template <class Ready>
+  bool parkProducer(CoroutineWaiter& waiter, Ready&& ready) noexcept {
+    return park(producerWaiter_, waiter, ready);
+  }
+
+ private:
+  using slot_type = std::atomic<CoroutineWaiter*>;
+
+  // the waiter is handed over with RMWs only: whichever of park() and
+  // wake() comes second sees the other
+  static void wake(slot_type& slot) noexcept {
+    auto waiter = slot.exchange(nullptr, std::memory_order_acq_rel);
+    if (waiter == nullptr) {
+      return;
+    }
+    // parked on a state older than our cursor, the next notify resumes it
+    if (!waiter->ready(*waiter)) {
+      slot.exchange(waiter, std::memory_order_acq_rel);
+      return;
+    }
+    waiter->resume(waiter->handle, waiter->executor);
+  }
+  template <class Ready>
+  static bool park(slot_type& slot,
+                   CoroutineWaiter& waiter,
+                   Ready& ready) noexcept {
+    slot.exchange(&waiter, std::memory_order_acq_rel);
+    if (!ready()) {
+      return true;
+    }
+    // take it back, unless the other side already did and resumes it
+    return slot.exchange(nullptr, std::memory_order_acq_rel) != &waiter;
+  }
+
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  alignas(hardware_destructive_interference_size) slot_type consumerWaiter_{};
+  alignas(hardware_destructive_interference_size) slot_type producerWaiter_{};
+};
+
+namespace detail {
+// the executor gets the handle as typed by the awaiter: one reading the
+// promise (its priority, its scheduler) only accepts its own coroutines
+template <class Executor, class Promise>
+void resumeOn(std::coroutine_handle<> handle, void* executor) {
+  static_cast<Executor*>(executor)->post(
+      std::coroutine_handle<Promise>::from_address(handle.address()));
+}
+
+// the readiness checks only see the published cursors of the FIFO (size()):
+// once parked the coroutine may run on the waking side at any time
+template <class Fifo, class Executor>
+class PopAwaiter : private CoroutineWaiter {
+ public:
+  using value_type = typename Fifo::value_type;
+
+  PopAwaiter(Fifo& fifo, CoroutineWait& wait, Executor& executor) noexcept
+      : CoroutineWaiter{{}, readable, nullptr, &executor},
+        fifo_(fifo),
+        wait_(wait) {}
+
+  bool await_ready() {
+    value_ = fifo_.pop();
+    return value_.has_value();
+  }
+  template <class Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    // the producer has to see the slots freed so far
+    fifo_.flush_pop();
+    this->handle = handle;
+    this->resume = resumeOn<Executor, Promise>;
+    auto ready = [fifo = &fifo_] { return !fifo->empty(); };
+    while (!wait_.parkConsumer(*this, ready)) {
+      value_ = fifo_.pop();
+      if (value_) {
+        return false;
+      }
+    }
+    return true;
+  }
+  // only the consumer pops: the element it was resumed for is still there
+  value_type await_resume() {
+    if (!value_) {
+      value_ = fifo_.pop();
+    }
+    return std::move(*value_);
+  }
+
+ private:
+  static bool readable(const CoroutineWaiter& waiter) noexcept {
+    return !static_cast<const PopAwaiter&>(waiter).fifo_.empty();
+  }
+
+  Fifo& fifo_;
+  CoroutineWait& wait_;
+  std::optional<value_type> value_;
+};
+
+template <class Fifo, class Executor>
+class PushAwaiter : private CoroutineWaiter {
+ public:
+  using value_type = typename Fifo::value_type;
+
+  PushAwaiter(Fifo& fifo,
+              CoroutineWait& wait,
+              Executor& executor,
+              value_type value) noexcept
+      : CoroutineWaiter{{}, writable, nullptr, &executor},
+        fifo_(fifo),
+        wait_(wait),
+        value_(std::move(value)) {}
+
+  bool await_ready() { return pushed_ = fifo_.push(std::move(value_)); }
+  template <class Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    // the consumer has to see the elements pushed so far
+    fifo_.flush_push();
+    this->handle = handle;
+    this->resume = resumeOn<Executor, Promise>;
+    auto ready = [fifo = &fifo_] { return !fifo->full(); };
+    while (!wait_.parkProducer(*this, ready)) {
+      if ((pushed_ = fifo_.push(std::move(value_)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+  // only the producer pushes: the slot it was resumed for is still free
+  void await_resume() {
+    if (!pushed_) {
+      fifo_.push(std::move(value_));
+    }
+  }
+
+ private:
+  static bool writable(const CoroutineWaiter& waiter) noexcept {
+    return !static_cast<const PushAwaiter&>(waiter).fifo_.full();
+  }
+
+  Fifo& fifo_;
+  CoroutineWait& wait_;
+  value_type value_;
+  bool pushed_ = false;
+};
+}  // namespace detail
+
+#endif  // UTILITY_COROUTINE_WAIT_HPP_
@@ -0,0 +1,69 @@
+#ifndef UTILITY_CURSOR_HPP_
+#define UTILITY_CURSOR_HPP_
+
+#include <atomic>
+
+// cursor policies of BasicFifo: the type of pushCursor_/popCursor_ and how
+// each side loads and publishes them. loadOwn() reads the cursor owned by
+// the calling side, loadOther() the cursor of the other side, publish()
+// moves the owned cursor from `from` to `to`
+
+// plain integers, no synchronization at all (Fifo1)
+struct PlainCursors {
+  template <class Size>
+  using cursor_type = Size;
+
+  template <class Size>
+  static Size loadOwn(const Size& cursor) noexcept {
+    return cursor;
+  }
+  template <class Size>
+  static Size loadOther(const Size& cursor) noexcept {
+    return cursor;
+  }
+  template <class Size>
+  static void publish(Size& cursor, Size, Size to) noexcept {
+    cursor = to;
+  }
+};
+
+// sequentially consistent atomics, published with a RMW (Fifo2)
+struct SeqCstCursors {
+  template <class Size>
+  using cursor_type = std::atomic<Size>;
+
+  template <class Size>
+  static Size loadOwn(const std::atomic<Size>& cursor) noexcept {
+    return cursor.load();
+  }
+  template <class Size>
+  static Size loadOther(const std::atomic<Size>& cursor) noexcept {
+    return cursor.load();
+  }
+  template <class Size>
+  static void publish(std::atomic<Size>& cursor, Size from, Size to) noexcept {
+    cursor += to - from;
+  }
+};
+
+// relaxed loads of the owned cursor, acquire loads of the other one and
+// release stores (Fifo3, Fifo4)
+struct AcqRelCursors {
+  template <class Size>
+  using cursor_type = std::atomic<Size>;
+
+  template <class Size>
+  static Size loadOwn(const std::atomic<Size>& cursor) noexcept {
+    return cursor.load(std::memory_order_relaxed);
+  }
+  template <class Size>
+  static Size loadOther(const std::atomic<Size>& cursor) noexcept {
+    return cursor.load(std::memory_order_acquire);
+  }
+  template <class Size>
+  static void publish(std::atomic<Size>& cursor, Size, Size to) noexcept {
+    cursor.store(to, std::memory_order_release);
+  }
+};
+
+#endif  // UTILITY_CURSOR_HPP_
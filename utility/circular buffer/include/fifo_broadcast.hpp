@@ -0,0 +1,213 @@
+#ifndef UTILITY_FIFO_BROADCAST_HPP_
+#define UTILITY_FIFO_BROADCAST_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "capacity.hpp"
+
+// lag policies of FifoBroadcast: what the writer does when the ring is full
+// because of the slowest reader
+
+// the writer waits for the slowest reader, push() returns false
+struct BlockOnLag {
+  static constexpr bool kOverwrite = false;
+};
+// the writer overwrites the oldest elements, a reader which was lapped
+// detects it, skips to the oldest element still in the ring and counts the
+// elements it lost. the elements are copied out seqlock style, so they have
+// to be trivially copyable
+struct OverwriteOnLag {
+  static constexpr bool kOverwrite = true;
+};
+
+namespace detail {
+inline constexpr size_t kBroadcastCacheLine = 64;
+
+// state of one reader of FifoBroadcast: cursor is read by the writer, the
+// rest is private to the reader thread
+template <class SizeType>
+struct BroadcastReader {
+  alignas(kBroadcastCacheLine) std::atomic<SizeType> cursor{};
+  alignas(kBroadcastCacheLine) SizeType cachedPushCursor{};
+  SizeType lost{};
+};
+}  // namespace detail
+
+// thread safe, single writer multi reader FIFO: every reader sees every
+// element (unless lapped with OverwriteOnLag). same cached cursor scheme as
+// Fifo4, each reader has its own cursor and cached push cursor, the writer
+// only caches the cursor of the slowest reader. when the ring looks full it
+// reloads that cursor alone, and scans all the readers only once it moved:
+// a reader lagging behind costs one load per push, not a scan.
+//
+// reader ids are 0..readers()-1, each id must be used by one thread only
+template <class Tp,
+          class Alloc = std::allocator<Tp>,
+          class Capacity = PowerOfTwoCapacity,
+          class Lag = BlockOnLag>
+class FifoBroadcast : private Alloc {
+  static_assert(!Lag::kOverwrite || std::is_trivially_copyable_v<Tp>,
+                "OverwriteOnLag copies the elements while they may be "
+                "overwritten, they should be trivially copyable");
+
+ public:
+  using value_type = Tp;
+  using pointer_type = Tp*;
+  using allocator_type = Alloc;
+  using allocator_traits = std::allocator_traits<Alloc>;
+  using size_type = typename allocator_traits::size_type;
+  explicit FifoBroadcast(size_type sz,
+                         size_type readers,
+                         const Alloc& alloc = Alloc{})
+      : Alloc(alloc),
+        capacity_(sz),
+        ring_(allocator_traits::allocate(*this, capacity_.capacity())),
+        readerCount_(std::max<size_type>(readers, 1)),
+        readers_(std::make_unique<reader_type[]>(readerCount_)) {}
+  FifoBroadcast(const FifoBroadcast&) = delete;
+  FifoBroadcast& operator=(const FifoBroadcast&) = delete;
+
+  FifoBroadcast(FifoBroadcast&&) = delete;
+  FifoBroadcast& operator=(FifoBroadcast&&) = delete;
+
+  ~FifoBroadcast() {
+    // the elements are destroyed by the writer when it reuses a slot, the
+    // last lap is still alive
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    auto first = pushIdx - std::min<size_type>(pushIdx, capacity_.capacity());
+    for (; first != pushIdx; ++first) {
+      ring_[capacity_.index(first)].~Tp();
+    }
+    allocator_traits::deallocate(*this, ring_, capacity_.capacity());
+  }
+  auto capacity() const noexcept { return capacity_.capacity(); }
+  auto readers() const noexcept { return readerCount_; }
+  // the number of elements reader has not read yet
+  auto size(size_type reader) const noexcept {
+    auto pushIdx = pushCursor_.load(std::memory_order_acquire);
+    auto popIdx = readers_[reader].cursor.load(std::memory_order_acquire);
+    return std::min(pushIdx - popIdx, capacity_.capacity());
+  }
+  auto empty(size_type reader) const noexcept { return size(reader) == 0; }
+  // the number of elements reader skipped because the writer lapped it,
+  // always 0 with BlockOnLag. reader thread only
+  auto lost(size_type reader) const noexcept { return readers_[reader].lost; }
+
+  auto push(const Tp& value) { return emplace(value); }
+  auto push(Tp&& value) { return emplace(std::move(value)); }
+  template <class... Args>
+  auto emplace(Args&&... args) {
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    if (full(cachedMinCursor_, pushIdx)) {
+      // the cursors only move forward: as long as the slowest reader stays
+      // where it was, the minimum is still cachedMinCursor_
+      auto slowest = readers_[slowest_].cursor.load(std::memory_order_acquire);
+      if (slowest != cachedMinCursor_) {
+        cachedMinCursor_ = slowestReader();
+      }
+      if (full(cachedMinCursor_, pushIdx)) {
+        if constexpr (!Lag::kOverwrite) {
+          return false;
+        } else {
+          // announce the overwrite before touching the slot, a reader that
+          // copied it meanwhile sees writeCursor_ past its cursor
+          writeCursor_.store(pushIdx + 1, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_release);
+        }
+      }
+    }
+    auto slot = &ring_[capacity_.index(pushIdx)];
+    if (pushIdx >= capacity_.capacity()) {
+      slot->~Tp();
+    }
+    ::new (slot) Tp(std::forward<Args>(args)...);
+    pushCursor_.store(pushIdx + 1, std::memory_order_release);
+    return true;
+  }
+
+  // copy the oldest element not read by reader, return false if there is
+  // none
+  auto pop(size_type reader, value_type& value) {
+    auto& state = readers_[reader];
+    auto popIdx = state.cursor.load(std::memory_order_relaxed);
+    while (true) {
+      if (empty(popIdx, state.cachedPushCursor)) {
+        state.cachedPushCursor = pushCursor_.load(std::memory_order_acquire);
+        if (empty(popIdx, state.cachedPushCursor)) {
+          return false;
+        }
+      }
+      if constexpr (!Lag::kOverwrite) {
+        value = ring_[capacity_.index(popIdx)];
+        break;
+      } else {
+        std::memcpy(static_cast<void*>(&value),
+                    &ring_[capacity_.index(popIdx)], sizeof(Tp));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto written = writeCursor_.load(std::memory_order_relaxed);
+        if (written <= popIdx + capacity_.capacity()) {
+          break;
+        }
+        // lapped: the copy may be torn, restart from the oldest slot the
+        // writer has not claimed yet
+        auto oldest = written - capacity_.capacity();
+        state.lost += oldest - popIdx;
+        popIdx = oldest;
+      }
+    }
+    state.cursor.store(popIdx + 1, std::memory_order_release);
+    return true;
+  }
+  auto pop(size_type reader) -> std::optional<Tp> {
+    std::optional<Tp> value{std::in_place};
+    if (!pop(reader, *value)) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+ private:
+  using reader_type = detail::BroadcastReader<size_type>;
+
+  // a lapped reader is more than capacity behind the writer
+  auto full(size_type popIdx, size_type pushIdx) {
+    return (pushIdx - popIdx) >= capacity_.capacity();
+  }
+  // a reader resynced after a lap may be ahead of its cached push cursor
+  auto empty(size_type popIdx, size_type pushIdx) { return popIdx >= pushIdx; }
+  // the cursor of the slowest reader, which is kept in slowest_
+  size_type slowestReader() noexcept {
+    auto slowest = std::numeric_limits<size_type>::max();
+    for (size_type r = 0; r < readerCount_; ++r) {
+      auto cursor = readers_[r].cursor.load(std::memory_order_acquire);
+      if (cursor < slowest) {
+        slowest = cursor;
+        slowest_ = r;
+      }
+    }
+    return slowest;
+  }
+  static constexpr size_t hardware_destructive_interference_size =
+      detail::kBroadcastCacheLine;
+  using cursor_type = std::atomic<size_type>;
+  static_assert(cursor_type::is_always_lock_free, "size_type should lock-free");
+  [[no_unique_address]] Capacity capacity_;
+  pointer_type ring_;
+  size_type readerCount_;
+  std::unique_ptr<reader_type[]> readers_;
+  alignas(hardware_destructive_interference_size) cursor_type pushCursor_{};
+  // the last push which overwrote an element some reader had not read
+  cursor_type writeCursor_{};
+  alignas(hardware_destructive_interference_size) size_type cachedMinCursor_{};
+  size_type slowest_{};
+};
+
+#endif  // UTILITY_FIFO_BROADCAST_HPP_
@@ -0,0 +1,177 @@
+#ifndef UTILITY_FIFO_BYTES_HPP_
+#define UTILITY_FIFO_BYTES_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+
+// thread safe, single producer single consumer FIFO of variable length
+// records. same cached cursor scheme as Fifo4 but the cursors count bytes.
+// every record is a 8 bytes header holding its length followed by the
+// payload, padded to 8 bytes. a record never wraps: when it does not fit
+// before the end of the ring a padding marker tells the consumer to skip to
+// the start
+template <class Alloc = std::allocator<std::byte>>
+class FifoBytes : private Alloc {
+ public:
+  using value_type = std::byte;
+  using pointer_type = std::byte*;
+  using allocator_traits = std::allocator_traits<Alloc>;
+  using size_type = typename allocator_traits::size_type;
+  static constexpr size_type kAlignment = 8;
+  static constexpr size_type kHeaderSize = kAlignment;
+
+  // sz is the number of bytes of the ring, rounded up to a power of two
+  explicit FifoBytes(size_type sz, const Alloc& alloc = Alloc{})
+      : Alloc(alloc),
+        capacity_(std::bit_ceil(std::max(sz, 2 * kHeaderSize))),
+        ring_(allocator_traits::allocate(*this, capacity_)) {}
+  FifoBytes(const FifoBytes&) = delete;
+  FifoBytes& operator=(const FifoBytes&) = delete;
+
+  FifoBytes(FifoBytes&&) = delete;
+  FifoBytes& operator=(FifoBytes&&) = delete;
+
+  ~FifoBytes() { allocator_traits::deallocate(*this, ring_, capacity_); }
+  // the number of bytes in use, headers and padding included
+  auto size() const noexcept {
+    assert(popCursor_ <= pushCursor_);
+    return pushCursor_ - popCursor_;
+  }
+  auto empty() const noexcept { return size() == 0; }
+  auto capacity() const noexcept { return capacity_; }
+  // the largest record that can ever be reserved. the length header is 32
+  // bits and its largest value marks the padding
+  auto max_record() const noexcept {
+    return std::min<size_type>(capacity_ / 2 - kHeaderSize, kPadding - 1);
+  }
+
+  // zero-copy producer: return n contiguous bytes to write the record into,
+  // or a span without data if there is no room. the record is published by commit()
+  auto reserve(size_type n) -> std::span<std::byte> {
+    if (n > max_record()) {
+      return {};
+    }
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    auto offset = pushIdx & (capacity_ - 1);
+    auto record = recordSize(n);
+    // skip the tail of the ring if the record does not fit there
+    auto skip = capacity_ - offset < record ? capacity_ - offset : 0;
+    if (available(cachedPopCursor_, pushIdx) < skip + record) {
+      cachedPopCursor_ = popCursor_.load(std::memory_order_acquire);
+      if (available(cachedPopCursor_, pushIdx) < skip + record) {
+        return {};
+      }
+    }
+    if (skip != 0) {
+      writeHeader(offset, kPadding);
+      offset = 0;
+    }
+    writeHeader(offset, static_cast<std::uint32_t>(n));
+    pendingPush_ = skip + record;
+    pendingOffset_ = offset;
+    return {ring_ + offset + kHeaderSize, n};
+  }
+  // publish the record returned by reserve()
+  void commit() {
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    pushCursor_.store(pushIdx + pendingPush_, std::memory_order_release);
+  }
+  // publish only the first n bytes of the record returned by reserve()
+  void commit(size_type n) {
+    auto reserved = readHeader(pendingOffset_);
+    assert(n <= reserved);
+    writeHeader(pendingOffset_, static_cast<std::uint32_t>(n));
+    pendingPush_ -= recordSize(reserved) - recordSize(n);
+    commit();
+  }
+
+  // zero-copy consumer: return the oldest record or a span without data if
+  // there is none, the bytes stay valid until release()
+  auto read() -> std::span<const std::byte> {
+    auto popIdx = popCursor_.load(std::memory_order_relaxed);
+    if (popIdx == cachedPushCursor_) {
+      cachedPushCursor_ = pushCursor_.load(std::memory_order_acquire);
+      if (popIdx == cachedPushCursor_) {
+        return {};
+      }
+    }
+    auto offset = popIdx & (capacity_ - 1);
+    auto n = readHeader(offset);
+    size_type skip = 0;
+    if (n == kPadding) {
+      // the producer publishes the padding and the record together
+      skip = capacity_ - offset;
+      offset = 0;
+      n = readHeader(offset);
+    }
+    pendingPop_ = skip + recordSize(n);
+    return {ring_ + offset + kHeaderSize, n};
+  }
+  // drop the record returned by read()
+  void release() {
+    auto popIdx = popCursor_.load(std::memory_order_relaxed);
+    popCursor_.store(popIdx + pendingPop_, std::memory_order_release);
+  }
+
+  // copying helpers on top of reserve/commit and read/release
+  auto push(std::span<const std::byte> record) {
+    auto out = reserve(record.size());
+    // a zero length record has an empty span as well
+    if (out.data() == nullptr) {
+      return false;
+    }
+    std::memcpy(out.data(), record.data(), record.size());
+    commit();
+    return true;
+  }
+  template <class F>
+  auto try_pop(F&& consumer) {
+    auto record = read();
+    if (record.data() == nullptr) {
+      return false;
+    }
+    std::forward<F>(consumer)(record);
+    release();
+    return true;
+  }
+
+ private:
+  static constexpr std::uint32_t kPadding = ~std::uint32_t{0};
+
+  static constexpr size_type recordSize(size_type n) noexcept {
+    return (kHeaderSize + n + kAlignment - 1) & ~(kAlignment - 1);
+  }
+  void writeHeader(size_type offset, std::uint32_t n) noexcept {
+    std::memcpy(ring_ + offset, &n, sizeof(n));
+  }
+  std::uint32_t readHeader(size_type offset) const noexcept {
+    std::uint32_t n;
+    std::memcpy(&n, ring_ + offset, sizeof(n));
+    return n;
+  }
+  auto available(size_type popIdx, size_type pushIdx) {
+    return capacity_ - (pushIdx - popIdx);
+  }
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  using cursor_type = std::atomic<size_type>;
+  static_assert(cursor_type::is_always_lock_free, "size_type should lock-free");
+  size_type capacity_;
+  pointer_type ring_;
+  alignas(hardware_destructive_interference_size) cursor_type pushCursor_{};
+  alignas(hardware_destructive_interference_size) size_type cachedPushCursor_{};
+  size_type pendingPop_{};
+  alignas(hardware_destructive_interference_size) cursor_type popCursor_{};
+  alignas(hardware_destructive_interference_size) size_type cachedPopCursor_{};
+  size_type pendingPush_{};
+  size_type pendingOffset_{};
+};
+
+#endif  // UTILITY_FIFO_BYTES_HPP_
@@ -0,0 +1,178 @@
+#ifndef UTILITY_FIFO_LOSSY_HPP_
+#define UTILITY_FIFO_LOSSY_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "capacity.hpp"
+
+// consumer policies of FifoLossy
+struct SingleConsumer {
+  static constexpr bool kShared = false;
+};
+// the consumers share the stream, each element goes to one of them
+struct MultiConsumer {
+  static constexpr bool kShared = true;
+};
+
+namespace detail {
+// slot of FifoLossy: seq is 2 * i + 1 while the producer writes the element
+// of cursor i and 2 * i + 2 once it is written, 0 if never written
+template <class Tp>
+struct LossySlot {
+  std::atomic<std::uint64_t> seq;
+  alignas(Tp) unsigned char storage[sizeof(Tp)];
+};
+}  // namespace detail
+
+// thread safe, single producer FIFO which never blocks the producer: when
+// the consumer falls behind the producer overwrites the oldest elements.
+// push() is wait-free, it does not read anything the consumers write.
+//
+// the consumer checks the sequence stamp of the slot before and after
+// copying the element out (seqlock), a stamp ahead of its cursor means it
+// was lapped: it skips to the oldest element which may still be in the ring
+// and counts the skipped elements in dropped(). the elements are copied
+// while they may be overwritten, so they have to be trivially copyable
+template <class Tp,
+          class Alloc = std::allocator<Tp>,
+          class Capacity = PowerOfTwoCapacity,
+          class Consumers = SingleConsumer>
+class FifoLossy
+    : private std::allocator_traits<Alloc>::template rebind_alloc<
+          detail::LossySlot<Tp>> {
+  static_assert(std::is_trivially_copyable_v<Tp>,
+                "FifoLossy copies the elements while they may be "
+                "overwritten, they should be trivially copyable");
+  using slot_type = detail::LossySlot<Tp>;
+  using slot_allocator = typename std::allocator_traits<
+      Alloc>::template rebind_alloc<slot_type>;
+  using slot_traits = std::allocator_traits<slot_allocator>;
+
+ public:
+  using value_type = Tp;
+  using pointer_type = Tp*;
+  using allocator_traits = std::allocator_traits<Alloc>;
+  using size_type = typename allocator_traits::size_type;
+  explicit FifoLossy(size_type sz, const Alloc& alloc = Alloc{})
+      : slot_allocator(alloc),
+        capacity_(sz),
+        ring_(slot_traits::allocate(*this, capacity_.capacity())) {
+    for (size_type i = 0; i < capacity_.capacity(); ++i) {
+      ::new (&ring_[i].seq) std::atomic<std::uint64_t>{0};
+    }
+  }
+  FifoLossy(const FifoLossy&) = delete;
+  FifoLossy& operator=(const FifoLossy&) = delete;
+
+  FifoLossy(FifoLossy&&) = delete;
+  FifoLossy& operator=(FifoLossy&&) = delete;
+
+  ~FifoLossy() { slot_traits::deallocate(*this, ring_, capacity_.capacity()); }
+  auto capacity() const noexcept { return capacity_.capacity(); }
+  // only a snapshot, at most capacity() even if the consumer was lapped
+  auto size() const noexcept {
+    auto popIdx = popCursor_.load(std::memory_order_acquire);
+    auto pushIdx = pushCursor_.load(std::memory_order_acquire);
+    auto behind = pushIdx > popIdx ? pushIdx - popIdx : size_type{0};
+    return behind < capacity() ? behind : capacity();
+  }
+  auto empty() const noexcept { return size() == 0; }
+  // the elements overwritten before a consumer could pop them, may be read
+  // from any thread
+  auto dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // never fails, overwrites the oldest element when the ring is full
+  void push(const Tp& value) noexcept {
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    auto& slot = ring_[capacity_.index(pushIdx)];
+    // odd stamp first: a consumer copying the old element sees it changed.
+    // the fence orders it before the copy, tsan does not model it (its .tsan
+    // build passes -Wno-tsan)
+    slot.seq.store(2 * pushIdx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(slot.storage, &value, sizeof(Tp));
+    slot.seq.store(2 * pushIdx + 2, std::memory_order_release);
+    // only read by size() and by lapped consumers
+    pushCursor_.store(pushIdx + 1, std::memory_order_release);
+  }
+
+  // copy the oldest element still in the ring into value, return false if
+  // there is none
+  auto pop(value_type& value) noexcept {
+    auto popIdx = popCursor_.load(kCursorLoad);
+    while (true) {
+      auto& slot = ring_[capacity_.index(popIdx)];
+      auto seq = slot.seq.load(std::memory_order_acquire);
+      if (seq < 2 * popIdx + 2) {
+        return false;
+      }
+      if (seq == 2 * popIdx + 2) {
+        std::memcpy(static_cast<void*>(&value), slot.storage, sizeof(Tp));
+        // pairs with the fence of push(): the copy is done before the
+        // stamp is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto again = slot.seq.load(std::memory_order_relaxed);
+        if (again == seq) {
+          if (claim(popIdx, popIdx + 1)) {
+            return true;
+          }
+          continue;
+        }
+        seq = again;
+      }
+      // lapped: the slot holds (or is getting) the element of cursor
+      // latest, the elements older than latest - capacity + 1 are gone
+      auto latest = (seq - 1) / 2;
+      auto oldest = latest - capacity_.capacity() + 1;
+      if (claim(popIdx, oldest)) {
+        drop(oldest - popIdx);
+        popIdx = oldest;
+      }
+    }
+  }
+
+ private:
+  static constexpr bool kShared = Consumers::kShared;
+  static constexpr auto kCursorLoad =
+      kShared ? std::memory_order_acquire : std::memory_order_relaxed;
+
+  // move the pop cursor from `from` to `to`. the consumers race for it when
+  // shared, a loser gets the new cursor in from and retries
+  bool claim(size_type& from, size_type to) noexcept {
+    if constexpr (kShared) {
+      return popCursor_.compare_exchange_strong(from, to,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire);
+    } else {
+      popCursor_.store(to, std::memory_order_release);
+      return true;
+    }
+  }
+  void drop(size_type n) noexcept {
+    if constexpr (kShared) {
+      dropped_.fetch_add(n, std::memory_order_relaxed);
+    } else {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + n,
+                     std::memory_order_relaxed);
+    }
+  }
+
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  using cursor_type = std::atomic<size_type>;
+  static_assert(cursor_type::is_always_lock_free, "size_type should lock-free");
+  [[no_unique_address]] Capacity capacity_;
+  slot_type* ring_;
+  alignas(hardware_destructive_interference_size) cursor_type pushCursor_{};
+  alignas(hardware_destructive_interference_size) cursor_type popCursor_{};
+  cursor_type dropped_{};
+};
+
+#endif  // UTILITY_FIFO_LOSSY_HPP_
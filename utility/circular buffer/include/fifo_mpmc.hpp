@@ -0,0 +1,143 @@
+#ifndef UTILITY_FIFO_MPMC_HPP_
+#define UTILITY_FIFO_MPMC_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "capacity.hpp"
+
+namespace detail {
+// slot of FifoMpmc, seq tells which lap of the ring may touch the value
+template <class Tp>
+struct MpmcSlot {
+  std::atomic<std::size_t> seq;
+  alignas(Tp) unsigned char storage[sizeof(Tp)];
+
+  Tp* value() noexcept { return std::launder(reinterpret_cast<Tp*>(storage)); }
+};
+}  // namespace detail
+
+// thread safe, multi-producer/multi-consumer bounded FIFO (Dmitry Vyukov),
+// each slot carries a sequence number so that producers and consumers only
+// contend on their own cursor and on the slot they claimed. the ring has at
+// least 2 slots: with one, the free stamp of a lap is the written stamp of
+// the previous one
+template <class Tp,
+          class Alloc = std::allocator<Tp>,
+          class Capacity = PowerOfTwoCapacity>
+class FifoMpmc : private std::allocator_traits<Alloc>::template rebind_alloc<
+                     detail::MpmcSlot<Tp>> {
+  using slot_type = detail::MpmcSlot<Tp>;
+  using slot_allocator = typename std::allocator_traits<
+      Alloc>::template rebind_alloc<slot_type>;
+  using slot_traits = std::allocator_traits<slot_allocator>;
+
+ public:
+  using value_type = Tp;
+  using pointer_type = Tp*;
+  using allocator_traits = std::allocator_traits<Alloc>;
+  using size_type = typename allocator_traits::size_type;
+  explicit FifoMpmc(size_type sz, const Alloc& alloc = Alloc{})
+      : slot_allocator(alloc),
+        capacity_(std::max<size_type>(sz, 2)),
+        ring_(slot_traits::allocate(*this, capacity_.capacity())) {
+    // FixedCapacity ignores the requested size
+    assert(capacity_.capacity() >= 2);
+    for (size_type i = 0; i < capacity_.capacity(); ++i) {
+      ::new (&ring_[i].seq) std::atomic<std::size_t>{i};
+    }
+  }
+  FifoMpmc(const FifoMpmc&) = delete;
+  FifoMpmc& operator=(const FifoMpmc&) = delete;
+
+  FifoMpmc(FifoMpmc&&) = delete;
+  FifoMpmc& operator=(FifoMpmc&&) = delete;
+
+  ~FifoMpmc() {
+    auto popIdx = popCursor_.load(std::memory_order_relaxed);
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    for (; popIdx != pushIdx; ++popIdx) {
+      ring_[capacity_.index(popIdx)].value()->~Tp();
+    }
+    slot_traits::deallocate(*this, ring_, capacity_.capacity());
+  }
+  auto capacity() const noexcept { return capacity_.capacity(); }
+  // only a snapshot while producers or consumers are running
+  auto size() const noexcept {
+    auto popIdx = popCursor_.load(std::memory_order_acquire);
+    auto pushIdx = pushCursor_.load(std::memory_order_acquire);
+    return pushIdx > popIdx ? pushIdx - popIdx : size_type{0};
+  }
+  auto full() const noexcept { return size() >= capacity_.capacity(); }
+  auto empty() const noexcept { return size() == 0; }
+
+  auto push(const Tp& value) { return emplace(value); }
+  template <class... Args>
+  auto emplace(Args&&... args) {
+    auto pushIdx = pushCursor_.load(std::memory_order_relaxed);
+    slot_type* slot;
+    while (true) {
+      slot = &ring_[capacity_.index(pushIdx)];
+      auto seq = slot->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq - pushIdx);
+      if (diff == 0) {
+        // the slot is free in this lap, claim it
+        if (pushCursor_.compare_exchange_weak(pushIdx, pushIdx + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the slot still holds the value of the previous lap
+        return false;
+      } else {
+        pushIdx = pushCursor_.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (slot->storage) Tp(std::forward<Args>(args)...);
+    slot->seq.store(pushIdx + 1, std::memory_order_release);
+    return true;
+  }
+  auto pop(value_type& value) {
+    auto popIdx = popCursor_.load(std::memory_order_relaxed);
+    slot_type* slot;
+    while (true) {
+      slot = &ring_[capacity_.index(popIdx)];
+      auto seq = slot->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq - (popIdx + 1));
+      if (diff == 0) {
+        // the slot is written in this lap, claim it
+        if (popCursor_.compare_exchange_weak(popIdx, popIdx + 1,
+                                             std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the slot is not written yet
+        return false;
+      } else {
+        popIdx = popCursor_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(*slot->value());
+    slot->value()->~Tp();
+    // hand the slot over to the producer of the next lap
+    slot->seq.store(popIdx + capacity_.capacity(), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  using cursor_type = std::atomic<size_type>;
+  static_assert(cursor_type::is_always_lock_free, "size_type should lock-free");
+  [[no_unique_address]] Capacity capacity_;
+  slot_type* ring_;
+  alignas(hardware_destructive_interference_size) cursor_type pushCursor_{};
+  alignas(hardware_destructive_interference_size) cursor_type popCursor_{};
+};
+
+#endif  // UTILITY_FIFO_MPMC_HPP_
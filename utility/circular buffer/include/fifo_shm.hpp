@@ -0,0 +1,220 @@
+#ifndef UTILITY_FIFO_SHM_HPP_
+#define UTILITY_FIFO_SHM_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace detail {
+inline constexpr size_t kShmCacheLine = 64;
+
+// lives at the start of the shared memory region, the slots follow on the
+// next cache line
+struct ShmHeader {
+  static constexpr std::uint64_t kMagic = 0x314f464946534d48;  // "HMSFIFO1"
+  static constexpr std::uint32_t kVersion = 1;
+
+  // written last by the creator, an attacher never sees a half built header
+  std::atomic<std::uint64_t> magic;
+  std::uint32_t version;
+  std::uint32_t valueSize;
+  std::uint64_t capacity;
+  alignas(kShmCacheLine) std::atomic<std::uint64_t> pushCursor;
+  alignas(kShmCacheLine) std::atomic<std::uint64_t> popCursor;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "cursors should be address free to live in shared memory");
+}  // namespace detail
+
+// thread/process safe, single producer single consumer FIFO whose cursors
+// and slots live in a POSIX shared memory object, so that the producer and
+// the consumer may be two processes. one process create()s the ring, the
+// other attach()es to it by name. same cursor scheme as Fifo4: the cached
+// cursors are private to each process
+template <class Tp>
+class FifoShm {
+  static_assert(std::is_trivially_copyable_v<Tp>,
+                "only trivially copyable values may cross processes");
+
+ public:
+  using value_type = Tp;
+  using pointer_type = Tp*;
+  using size_type = std::uint64_t;
+
+  // create a new shared memory object, sz is rounded up to a power of two.
+  // throws if the name already exists
+  static FifoShm create(const std::string& name, size_type sz) {
+    return FifoShm{name, sz, true};
+  }
+  // attach to a ring created by another process, throws if the name does
+  // not exist or if its layout does not match this build
+  static FifoShm attach(const std::string& name) {
+    return FifoShm{name, 0, false};
+  }
+  static void unlink(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+  FifoShm(const FifoShm&) = delete;
+  FifoShm& operator=(const FifoShm&) = delete;
+
+  FifoShm(FifoShm&&) = delete;
+  FifoShm& operator=(FifoShm&&) = delete;
+
+  ~FifoShm() {
+    ::munmap(header_, mapSize_);
+    ::close(fd_);
+  }
+  auto capacity() const noexcept { return mask_ + 1; }
+  auto size() const noexcept {
+    return header_->pushCursor.load(std::memory_order_acquire) -
+           header_->popCursor.load(std::memory_order_acquire);
+  }
+  auto full() const noexcept { return size() == capacity(); }
+  auto empty() const noexcept { return size() == 0; }
+
+  auto push(const Tp& value) {
+    auto pushIdx = header_->pushCursor.load(std::memory_order_relaxed);
+    if (full(cachedPopCursor_, pushIdx)) {
+      cachedPopCursor_ = header_->popCursor.load(std::memory_order_acquire);
+      if (full(cachedPopCursor_, pushIdx)) {
+        return false;
+      }
+    }
+    std::memcpy(&ring_[pushIdx & mask_], &value, sizeof(Tp));
+    header_->pushCursor.store(pushIdx + 1, std::memory_order_release);
+    return true;
+  }
+  auto pop(value_type& value) {
+    auto popIdx = header_->popCursor.load(std::memory_order_relaxed);
+    if (empty(popIdx, cachedPushCursor_)) {
+      cachedPushCursor_ = header_->pushCursor.load(std::memory_order_acquire);
+      if (empty(popIdx, cachedPushCursor_)) {
+        return false;
+      }
+    }
+    std::memcpy(&value, &ring_[popIdx & mask_], sizeof(Tp));
+    header_->popCursor.store(popIdx + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  using header_type = detail::ShmHeader;
+  static constexpr size_t kSlotsOffset =
+      (sizeof(header_type) + detail::kShmCacheLine - 1) /
+      detail::kShmCacheLine * detail::kShmCacheLine;
+  static_assert(alignof(Tp) <= detail::kShmCacheLine,
+                "slots are cache line aligned");
+
+  static void check(bool ok, const char* what) {
+    if (!ok) {
+      throw std::system_error{errno, std::generic_category(), what};
+    }
+  }
+  FifoShm(const std::string& name, size_type sz, bool create) {
+    if (create) {
+      auto capacity = std::bit_ceil(std::max<size_type>(sz, 1));
+      mapSize_ = kSlotsOffset + capacity * sizeof(Tp);
+      fd_ = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      check(fd_ >= 0, "shm_open");
+      if (::ftruncate(fd_, mapSize_) != 0) {
+        removeAndThrow(name, "ftruncate");
+      }
+      if (!map()) {
+        removeAndThrow(name, "mmap");
+      }
+      header_->version = header_type::kVersion;
+      header_->valueSize = sizeof(Tp);
+      header_->capacity = capacity;
+      ::new (&header_->pushCursor) std::atomic<std::uint64_t>{0};
+      ::new (&header_->popCursor) std::atomic<std::uint64_t>{0};
+      header_->magic.store(header_type::kMagic, std::memory_order_release);
+    } else {
+      fd_ = ::shm_open(name.c_str(), O_RDWR, 0);
+      check(fd_ >= 0, "shm_open");
+      struct ::stat st {};
+      if (::fstat(fd_, &st) != 0 ||
+          static_cast<size_t>(st.st_size) < kSlotsOffset) {
+        ::close(fd_);
+        throw std::runtime_error{"FifoShm: " + name + " is not a ring"};
+      }
+      mapSize_ = st.st_size;
+      if (!map()) {
+        auto err = errno;
+        ::close(fd_);
+        throw std::system_error{err, std::generic_category(), "mmap"};
+      }
+      validate(name);
+    }
+    mask_ = header_->capacity - 1;
+    // a ring attached to may have been used already: start from where it is
+    cachedPushCursor_ = header_->pushCursor.load(std::memory_order_acquire);
+    cachedPopCursor_ = header_->popCursor.load(std::memory_order_acquire);
+    ring_ = reinterpret_cast<pointer_type>(
+        reinterpret_cast<unsigned char*>(header_) + kSlotsOffset);
+  }
+  // false with errno set if the object cannot be mapped
+  bool map() {
+    auto addr = ::mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd_, 0);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    header_ = static_cast<header_type*>(addr);
+    return true;
+  }
+  // a create() which failed does not leave the name behind
+  [[noreturn]] void removeAndThrow(const std::string& name, const char* what) {
+    auto err = errno;
+    ::close(fd_);
+    ::shm_unlink(name.c_str());
+    throw std::system_error{err, std::generic_category(), what};
+  }
+  void validate(const std::string& name) {
+    const char* error = nullptr;
+    if (header_->magic.load(std::memory_order_acquire) !=
+        header_type::kMagic) {
+      error = "bad magic";
+    } else if (header_->version != header_type::kVersion) {
+      error = "version mismatch";
+    } else if (header_->valueSize != sizeof(Tp)) {
+      error = "value size mismatch";
+    } else if (!std::has_single_bit(header_->capacity) ||
+               mapSize_ < kSlotsOffset + header_->capacity * sizeof(Tp)) {
+      error = "bad capacity";
+    }
+    if (error != nullptr) {
+      ::munmap(header_, mapSize_);
+      ::close(fd_);
+      throw std::runtime_error{"FifoShm: " + name + ": " + error};
+    }
+  }
+  auto full(size_type popIdx, size_type pushIdx) {
+    return (pushIdx - popIdx) == capacity();
+  }
+  auto empty(size_type popIdx, size_type pushIdx) {
+    return (pushIdx - popIdx) == 0;
+  }
+  static constexpr size_t hardware_destructive_interference_size =
+      detail::kShmCacheLine;
+  int fd_ = -1;
+  size_t mapSize_ = 0;
+  header_type* header_ = nullptr;
+  size_type mask_ = 0;
+  pointer_type ring_ = nullptr;
+  alignas(hardware_destructive_interference_size) size_type cachedPushCursor_{};
+  alignas(hardware_destructive_interference_size) size_type cachedPopCursor_{};
+};
+
+#endif  // UTILITY_FIFO_SHM_HPP_
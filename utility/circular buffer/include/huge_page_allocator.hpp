@@ -0,0 +1,154 @@
+#ifndef UTILITY_HUGE_PAGE_ALLOCATOR_HPP_
+#define UTILITY_HUGE_PAGE_ALLOCATOR_HPP_
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <system_error>
+
+// allocator for the ring storage: the memory is mmapped with 1GB or 2MB huge
+// pages when the system has some reserved (falls back to regular pages
+// advised for transparent huge pages), bound to one NUMA node and prefaulted
+// so that the hot path never takes a page fault. a page size the node has
+// no free pages of left falls back to the next one. the ring starts on a page
+// boundary, its length is rounded up to whole 2MB (1GB from 1GB on) pages
+// whatever the pages backing it, so that deallocate() finds the mapping from
+// the element count alone.
+//
+// usage: Fifo4<T, HugePageNumaAlloc<T>> fifo{sz, HugePageNumaAlloc<T>::onCpu(
+//            consumerCpu)};
+template <class Tp>
+class HugePageNumaAlloc {
+ public:
+  using value_type = Tp;
+  // no NUMA binding, the pages land where they are prefaulted
+  static constexpr int kAnyNode = -1;
+  static constexpr size_t k2MB = size_t{1} << 21;
+  static constexpr size_t k1GB = size_t{1} << 30;
+
+  HugePageNumaAlloc() noexcept = default;
+  explicit HugePageNumaAlloc(int node) noexcept : node_{node} {}
+  template <class Up>
+  HugePageNumaAlloc(const HugePageNumaAlloc<Up>& other) noexcept
+      : node_{other.node()} {}
+
+  // allocator bound to the NUMA node of cpu
+  static HugePageNumaAlloc onCpu(int cpu) {
+    return HugePageNumaAlloc{nodeOfCpu(cpu)};
+  }
+  // the NUMA node of cpu read from sysfs, kAnyNode if unknown
+  static int nodeOfCpu(int cpu) {
+    namespace fs = std::filesystem;
+    if (cpu < 0) {
+      return kAnyNode;
+    }
+    std::error_code ec;
+    fs::directory_iterator it{
+        "/sys/devices/system/cpu/cpu" + std::to_string(cpu), ec};
+    for (; !ec && it != fs::directory_iterator{}; it.increment(ec)) {
+      auto name = it->path().filename().string();
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0) {
+        return std::stoi(name.substr(4));
+      }
+    }
+    return kAnyNode;
+  }
+
+  int node() const noexcept { return node_; }
+
+  Tp* allocate(size_t n) {
+    auto length = mappingLength(n);
+    // 1GB pages only when they are not mostly wasted
+    for (auto page : {k1GB, k2MB}) {
+      if (page > length) {
+        continue;
+      }
+      if (auto p = map(length, page, MAP_HUGETLB | hugePageFlag(page))) {
+        return p;
+      }
+    }
+    if (auto p = map(length, ::sysconf(_SC_PAGESIZE), 0)) {
+      return p;
+    }
+    throw std::bad_alloc{};
+  }
+  void deallocate(Tp* p, size_t n) noexcept { ::munmap(p, mappingLength(n)); }
+
+  template <class Up>
+  friend bool operator==(const HugePageNumaAlloc& lhs,
+                         const HugePageNumaAlloc<Up>& rhs) noexcept {
+    return lhs.node() == rhs.node();
+  }
+
+ private:
+  // a multiple of every page size allocate() may map n elements with
+  static size_t mappingLength(size_t n) noexcept {
+    auto bytes = std::max<size_t>(n * sizeof(Tp), 1);
+    auto page = bytes < k1GB ? k2MB : k1GB;
+    return (bytes + page - 1) / page * page;
+  }
+  static int hugePageFlag(size_t page) noexcept {
+    // MAP_HUGE_2MB/MAP_HUGE_1GB: log2 of the page size in the flag bits
+    return __builtin_ctzl(page) << MAP_HUGE_SHIFT;
+  }
+  Tp* map(size_t length, size_t page, int flags) const noexcept {
+    auto addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (addr == MAP_FAILED) {
+      return nullptr;
+    }
+    if (flags == 0) {
+      ::madvise(addr, length, MADV_HUGEPAGE);
+    }
+    auto bound = bind(addr, length);
+    if (!prefault(addr, length, page, flags != 0 && bound)) {
+      ::munmap(addr, length);
+      return nullptr;
+    }
+    return static_cast<Tp*>(addr);
+  }
+  // allocate every page once the policy is set, so that it is on the right
+  // node now instead of faulted in on the hot path. mmap() reserved the huge
+  // pages from the pool of any node: touching one the bound node has none
+  // of left raises SIGBUS, MADV_POPULATE_WRITE fails instead
+  static bool prefault(void* addr,
+                       size_t length,
+                       size_t page,
+                       bool boundHugePages) noexcept {
+    if (::madvise(addr, length, MADV_POPULATE_WRITE) == 0) {
+      return true;
+    }
+    // before linux 5.14 only touching is left, unsafe for bound huge pages
+    if (errno != EINVAL || boundHugePages) {
+      return false;
+    }
+    auto first = static_cast<volatile char*>(addr);
+    for (size_t offset = 0; offset < length; offset += page) {
+      first[offset] = 0;
+    }
+    return true;
+  }
+  // best effort: a kernel without NUMA support leaves the default policy.
+  // true if the range is bound to node_
+  bool bind(void* addr, size_t length) const noexcept {
+    if (node_ < 0 || node_ >= static_cast<int>(sizeof(long) * CHAR_BIT)) {
+      return false;
+    }
+    unsigned long mask = 1UL << node_;
+    // maxnode counts one bit more than the mask holds, the kernel drops it
+    return ::syscall(SYS_mbind, addr, length, MPOL_BIND, &mask,
+                     sizeof(mask) * CHAR_BIT + 1, 0) == 0;
+  }
+
+  int node_ = kAnyNode;
+};
+
+#endif  // UTILITY_HUGE_PAGE_ALLOCATOR_HPP_
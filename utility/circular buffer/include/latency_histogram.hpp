@@ -0,0 +1,78 @@
+#ifndef UTILITY_LATENCY_HISTOGRAM_HPP_
+#define UTILITY_LATENCY_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// log-linear histogram (HdrHistogram style): values below 16 have their own
+// bucket, above that every power of two is split into 16 buckets, so the
+// relative error stays below 1/16 with a fixed footprint. the FIFO latency
+// benchmarks and the queueing delays of the coroutine scheduler record
+// nanoseconds in it
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBits = 4;
+  static constexpr std::uint64_t kSubCount = 1 << kSubBits;
+  static constexpr size_t kBuckets = (64 - kSubBits) * kSubCount + kSubCount;
+
+  void record(std::uint64_t value) noexcept {
+    ++buckets_[bucket(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  void merge(const LatencyHistogram& other) noexcept {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  std::uint64_t count() const noexcept { return count_; }
+  std::uint64_t min() const noexcept { return count_ ? min_ : 0; }
+  std::uint64_t max() const noexcept { return max_; }
+  // q in [0, 1], the lower bound of the bucket holding the q-quantile
+  std::uint64_t percentile(double q) const noexcept {
+    if (count_ == 0) {
+      return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(q * (count_ - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::clamp(lowerBound(i), min_, max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static size_t bucket(std::uint64_t value) noexcept {
+    if (value < kSubCount) {
+      return value;
+    }
+    auto shift = std::bit_width(value) - 1 - kSubBits;
+    auto sub = (value >> shift) & (kSubCount - 1);
+    return (shift + 1) * kSubCount + sub;
+  }
+  static std::uint64_t lowerBound(size_t idx) noexcept {
+    if (idx < kSubCount) {
+      return idx;
+    }
+    auto shift = idx / kSubCount - 1;
+    auto sub = idx % kSubCount;
+    return (kSubCount + sub) << shift;
+  }
+  std::array<std::uint64_t, kBuckets> buckets_{};
+  std::uint64_t count_ = 0;
+  std::uint64_t min_ = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t max_ = 0;
+};
+
+#endif  // UTILITY_LATENCY_HISTOGRAM_HPP_
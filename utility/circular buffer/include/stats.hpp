@@ -0,0 +1,82 @@
+#ifndef UTILITY_STATS_HPP_
+#define UTILITY_STATS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// statistics policies of the FIFOs: the producer reports its stalls and
+// cursor refreshes through the push hooks, the consumer through the pop
+// hooks
+
+// snapshot of the counters
+struct FifoCounters {
+  // push/reserve/push_n which found the ring full, retries included
+  std::uint64_t pushFull;
+  // pop/front/pop_n which found the ring empty, retries included
+  std::uint64_t popEmpty;
+  // times the producer reloaded the consumer cursor into its cache
+  std::uint64_t popCursorRefresh;
+  // times the consumer reloaded the producer cursor into its cache
+  std::uint64_t pushCursorRefresh;
+  // largest number of elements seen by the producer after a push
+  std::uint64_t highWater;
+};
+
+// no statistics, the hooks compile to nothing
+struct NoStats {
+  static constexpr bool kEnabled = false;
+  void pushFull() noexcept {}
+  void popEmpty() noexcept {}
+  void popCursorRefresh() noexcept {}
+  void pushCursorRefresh() noexcept {}
+  void pushed(std::size_t) noexcept {}
+};
+
+// counters owned by one side each and kept on its own cache lines, apart
+// from the cursors. the owner bumps them with a relaxed load and store (no
+// locked instruction), any thread may read them with counters()
+class FifoStats {
+ public:
+  static constexpr bool kEnabled = true;
+
+  void pushFull() noexcept { bump(pushFull_); }
+  void popEmpty() noexcept { bump(popEmpty_); }
+  void popCursorRefresh() noexcept { bump(popCursorRefresh_); }
+  void pushCursorRefresh() noexcept { bump(pushCursorRefresh_); }
+  void pushed(std::size_t size) noexcept {
+    if (size > highWater_.load(std::memory_order_relaxed)) {
+      highWater_.store(size, std::memory_order_relaxed);
+    }
+  }
+
+  FifoCounters counters() const noexcept {
+    return {pushFull_.load(std::memory_order_relaxed),
+            popEmpty_.load(std::memory_order_relaxed),
+            popCursorRefresh_.load(std::memory_order_relaxed),
+            pushCursorRefresh_.load(std::memory_order_relaxed),
+            highWater_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  using counter_type = std::atomic<std::uint64_t>;
+  static_assert(counter_type::is_always_lock_free,
+                "counters should be lock-free");
+
+  // single writer: no need for fetch_add
+  static void bump(counter_type& counter) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  // producer side
+  alignas(hardware_destructive_interference_size) counter_type pushFull_{};
+  counter_type popCursorRefresh_{};
+  counter_type highWater_{};
+  // consumer side
+  alignas(hardware_destructive_interference_size) counter_type popEmpty_{};
+  counter_type pushCursorRefresh_{};
+};
+
+#endif  // UTILITY_STATS_HPP_
@@ -0,0 +1,123 @@
+#ifndef UTILITY_WAIT_HPP_
+#define UTILITY_WAIT_HPP_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+// waiting policies of the FIFOs: the producer calls notifyConsumer() after
+// publishing the push cursor and the consumer calls notifyProducer() after
+// publishing the pop cursor. CoroutineWait (coroutine_wait.hpp) parks
+// coroutines instead of threads
+
+inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// busy polling only, the hooks compile to nothing
+struct NoWait {
+  static constexpr bool kBlocking = false;
+  static constexpr bool kAsync = false;
+  void notifyConsumer() noexcept {}
+  void notifyProducer() noexcept {}
+};
+
+// spin with pause for a while, then park on a futex. the fast path of the
+// other side only pays a fence and a load of the parked flag, which stays
+// shared in its cache, and writes it and enters the kernel only when the
+// waiter is really parked
+class FutexWait {
+ public:
+  using clock = std::chrono::steady_clock;
+  static constexpr bool kBlocking = true;
+  static constexpr bool kAsync = false;
+  static constexpr int kSpinCount = 1024;
+
+  void notifyConsumer() noexcept { wake(consumerParked_); }
+  void notifyProducer() noexcept { wake(producerParked_); }
+
+  // block the consumer until ready() or deadline, return ready()
+  template <class Ready>
+  bool waitConsumer(Ready&& ready, clock::time_point deadline) {
+    return wait(consumerParked_, ready, deadline);
+  }
+  // block the producer until ready() or deadline, return ready()
+  template <class Ready>
+  bool waitProducer(Ready&& ready, clock::time_point deadline) {
+    return wait(producerParked_, ready, deadline);
+  }
+
+ private:
+  using flag_type = std::atomic<std::uint32_t>;
+  static_assert(sizeof(flag_type) == sizeof(std::uint32_t),
+                "futex word should be 32 bits");
+
+  static long futex(flag_type& word,
+                    int op,
+                    std::uint32_t value,
+                    const ::timespec* timeout) noexcept {
+    return ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), op,
+                     value, timeout, nullptr, 0);
+  }
+  // the waiter raises the flag, then checks the cursor, the waker publishes
+  // the cursor, then checks the flag, each with a seq_cst fence in between:
+  // one of them sees the other's store, the waker only clears the flag and
+  // wakes when the waiter raised it
+  static void wake(flag_type& parked) noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed) != 0 &&
+        parked.exchange(0, std::memory_order_acq_rel) != 0) {
+      futex(parked, FUTEX_WAKE_PRIVATE, 1, nullptr);
+    }
+  }
+  template <class Ready>
+  static bool wait(flag_type& parked,
+                   Ready& ready,
+                   clock::time_point deadline) {
+    for (int i = 0; i < kSpinCount; ++i) {
+      if (ready()) {
+        return true;
+      }
+      cpuRelax();
+    }
+    while (true) {
+      parked.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) {
+        parked.store(0, std::memory_order_relaxed);
+        return true;
+      }
+      ::timespec ts{};
+      ::timespec* timeout = nullptr;
+      if (deadline != clock::time_point::max()) {
+        auto now = clock::now();
+        if (now >= deadline) {
+          parked.store(0, std::memory_order_relaxed);
+          return ready();
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      deadline - now)
+                      .count();
+        ts.tv_sec = ns / 1'000'000'000;
+        ts.tv_nsec = ns % 1'000'000'000;
+        timeout = &ts;
+      }
+      // returns at once if the waker already cleared the flag
+      futex(parked, FUTEX_WAIT_PRIVATE, 1, timeout);
+    }
+  }
+
+  static constexpr size_t hardware_destructive_interference_size = 64;
+  alignas(hardware_destructive_interference_size) flag_type consumerParked_{};
+  alignas(hardware_destructive_interference_size) flag_type producerParked_{};
+};
+
+#endif  // UTILITY_WAIT_HPP_
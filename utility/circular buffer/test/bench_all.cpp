@@ -0,0 +1,405 @@
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark/perf.hpp"
+
+// runs every FIFO benchmark of the manifest written by CMake (one line per
+// binary: name, path and arguments separated by tabs) several times, takes
+// the median throughput of each "name: N ops/s" line and compares it with
+// a JSON baseline. exits with 1 when one of them dropped by more than the
+// threshold
+
+namespace {
+
+struct Options {
+  std::string manifest;
+  std::string baseline;
+  std::string output;
+  int runs = 5;
+  double threshold = 5.0;
+  bool update = false;
+  std::vector<int> cpus;
+  std::optional<std::uint64_t> hitmEvent = defaultHitmEvent();
+};
+
+struct Binary {
+  std::string name;
+  std::string path;
+  std::vector<std::string> args;
+};
+
+// the medians of all runs: ops/s per bench, counters per binary
+struct Results {
+  std::map<std::string, double> opsPerSec;
+  std::map<std::string, std::map<std::string, double>> counters;
+};
+
+std::vector<std::string> split(const std::string& line, char sep) {
+  std::vector<std::string> fields;
+  std::istringstream in{line};
+  std::string field;
+  while (std::getline(in, field, sep)) {
+    if (!field.empty()) {
+      fields.push_back(field);
+    }
+  }
+  return fields;
+}
+
+std::vector<Binary> readManifest(const std::string& path) {
+  std::ifstream in{path};
+  if (!in) {
+    throw std::runtime_error("cannot read manifest " + path);
+  }
+  std::vector<Binary> binaries;
+  std::string line;
+  while (std::getline(in, line)) {
+    auto fields = split(line, '\t');
+    if (fields.size() < 2) {
+      continue;
+    }
+    binaries.push_back({fields[0], fields[1],
+                        fields.size() > 2 ? split(fields[2], ' ')
+                                          : std::vector<std::string>{}});
+  }
+  return binaries;
+}
+
+struct Run {
+  std::map<std::string, double> opsPerSec;
+  PerfSample perf;
+};
+
+// "Fifo4/32       :   123456 ops/s"
+std::optional<std::pair<std::string, double>> parseReport(
+    const std::string& line) {
+  constexpr std::string_view kUnit = " ops/s";
+  auto colon = line.rfind(':');
+  if (colon == std::string::npos || line.size() < kUnit.size() ||
+      line.compare(line.size() - kUnit.size(), kUnit.size(), kUnit) != 0) {
+    return std::nullopt;
+  }
+  auto name = line.substr(0, colon);
+  while (!name.empty() && std::isspace(name.back())) {
+    name.pop_back();
+  }
+  return std::pair{name, std::atof(line.c_str() + colon + 1)};
+}
+
+// fork, attach the counters while the child waits, then let it exec
+Run runOnce(const Binary& binary, const Options& options) {
+  int go[2];
+  int out[2];
+  if (::pipe(go) != 0 || ::pipe(out) != 0) {
+    throw std::runtime_error(std::string{"pipe: "} + std::strerror(errno));
+  }
+  auto pid = ::fork();
+  if (pid < 0) {
+    throw std::runtime_error(std::string{"fork: "} + std::strerror(errno));
+  }
+  if (pid == 0) {
+    ::close(go[1]);
+    ::close(out[0]);
+    ::dup2(out[1], STDOUT_FILENO);
+    char c;
+    if (::read(go[0], &c, 1) != 1) {
+      std::_Exit(EXIT_FAILURE);
+    }
+    if (!options.cpus.empty()) {
+      ::cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (auto cpu : options.cpus) {
+        CPU_SET(cpu, &cpuset);
+      }
+      if (::sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0) {
+        std::perror("sched_setaffinity");
+      }
+    }
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(binary.path.c_str()));
+    for (auto& arg : binary.args) {
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    ::execv(binary.path.c_str(), argv.data());
+    std::perror("execv");
+    std::_Exit(EXIT_FAILURE);
+  }
+  ::close(go[0]);
+  ::close(out[1]);
+  PerfCounters counters{pid, options.hitmEvent};
+  if (::write(go[1], "x", 1) != 1) {
+    throw std::runtime_error("cannot start " + binary.path);
+  }
+  ::close(go[1]);
+
+  Run run;
+  std::string output;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = ::read(out[0], buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, n);
+  }
+  ::close(out[0]);
+  int status;
+  ::waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    throw std::runtime_error(binary.name + " failed");
+  }
+  std::istringstream lines{output};
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (auto report = parseReport(line)) {
+      // a bench reported twice by the same binary keeps both
+      auto key = binary.name + "/" + report->first;
+      while (run.opsPerSec.contains(key)) {
+        key += "'";
+      }
+      run.opsPerSec[key] = report->second;
+    }
+  }
+  run.perf = counters.read();
+  return run;
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  auto mid = values.size() / 2;
+  return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+Results runAll(const std::vector<Binary>& binaries, const Options& options) {
+  Results results;
+  for (auto& binary : binaries) {
+    std::map<std::string, std::vector<double>> ops;
+    std::map<std::string, std::vector<double>> counters;
+    for (int r = 0; r < options.runs; ++r) {
+      std::cout << binary.name << ": run " << r + 1 << "/" << options.runs
+                << std::endl;
+      auto run = runOnce(binary, options);
+      for (auto& [name, value] : run.opsPerSec) {
+        ops[name].push_back(value);
+      }
+      auto add = [&](const char* name, std::optional<std::uint64_t> value) {
+        if (value) {
+          counters[name].push_back(static_cast<double>(*value));
+        }
+      };
+      add("cycles", run.perf.cycles);
+      add("instructions", run.perf.instructions);
+      add("cache_misses", run.perf.cacheMisses);
+      add("hitm", run.perf.hitm);
+    }
+    for (auto& [name, values] : ops) {
+      results.opsPerSec[name] = median(values);
+    }
+    for (auto& [name, values] : counters) {
+      results.counters[binary.name][name] = median(values);
+    }
+  }
+  return results;
+}
+
+void writeJson(const Results& results, const std::string& path) {
+  std::ofstream out{path};
+  if (!out) {
+    throw std::runtime_error("cannot write " + path);
+  }
+  out << std::fixed << std::setprecision(0) << "{\n  \"benches\": {";
+  const char* sep = "\n";
+  for (auto& [name, value] : results.opsPerSec) {
+    out << sep << "    \"" << name << "\": " << value;
+    sep = ",\n";
+  }
+  out << "\n  },\n  \"counters\": {";
+  sep = "\n";
+  for (auto& [binary, counters] : results.counters) {
+    out << sep << "    \"" << binary << "\": {";
+    const char* inner = "";
+    for (auto& [name, value] : counters) {
+      out << inner << "\"" << name << "\": " << value;
+      inner = ", ";
+    }
+    out << "}";
+    sep = ",\n";
+  }
+  out << "\n  }\n}\n";
+}
+
+// reads back what writeJson() wrote: "name": number pairs, nested one level
+// in "benches" or two levels in "counters"
+Results readJson(const std::string& path) {
+  std::ifstream in{path};
+  if (!in) {
+    throw std::runtime_error("cannot read baseline " + path);
+  }
+  std::string text{std::istreambuf_iterator<char>{in}, {}};
+  Results results;
+  std::vector<std::string> keys;
+  std::string pending;
+  for (size_t i = 0; i < text.size(); ++i) {
+    auto c = text[i];
+    if (c == '"') {
+      auto end = text.find('"', i + 1);
+      pending = text.substr(i + 1, end - i - 1);
+      i = end;
+    } else if (c == '{') {
+      keys.push_back(pending);
+    } else if (c == '}') {
+      keys.pop_back();
+    } else if (c == '-' || std::isdigit(c)) {
+      char* end;
+      auto value = std::strtod(text.c_str() + i, &end);
+      i = end - text.c_str() - 1;
+      if (keys.size() == 2 && keys[1] == "benches") {
+        results.opsPerSec[pending] = value;
+      } else if (keys.size() == 3 && keys[1] == "counters") {
+        results.counters[keys[2]][pending] = value;
+      }
+    }
+  }
+  return results;
+}
+
+// print the comparison, return false on a regression beyond the threshold
+bool compare(const Results& current,
+             const Results& baseline,
+             double threshold) {
+  bool ok = true;
+  std::cout << std::fixed << std::setprecision(1);
+  for (auto& [name, value] : current.opsPerSec) {
+    std::cout << std::setw(40) << std::left << name << std::setw(14)
+              << std::right << static_cast<long>(value) << " ops/s";
+    auto it = baseline.opsPerSec.find(name);
+    if (it == baseline.opsPerSec.end() || it->second <= 0) {
+      std::cout << "  (new)\n";
+      continue;
+    }
+    auto delta = 100.0 * (value - it->second) / it->second;
+    std::cout << std::setw(9) << std::showpos << delta << std::noshowpos
+              << "%";
+    if (delta < -threshold) {
+      std::cout << "  REGRESSION";
+      ok = false;
+    }
+    std::cout << "\n";
+  }
+  for (auto& [binary, counters] : current.counters) {
+    std::cout << binary << ":";
+    for (auto& [name, value] : counters) {
+      std::cout << "  " << name << " " << static_cast<std::uint64_t>(value);
+      auto base = baseline.counters.find(binary);
+      if (base != baseline.counters.end() && base->second.contains(name) &&
+          base->second.at(name) > 0) {
+        auto old = base->second.at(name);
+        std::cout << " (" << std::showpos << 100.0 * (value - old) / old
+                  << std::noshowpos << "%)";
+      }
+    }
+    if (counters.contains("cycles") && counters.contains("instructions")) {
+      std::cout << std::setprecision(2) << "  ipc "
+                << counters.at("instructions") / counters.at("cycles")
+                << std::setprecision(1);
+    }
+    std::cout << "\n";
+  }
+  return ok;
+}
+
+// usage: bench_all --manifest FILE --baseline FILE [--output FILE]
+//   [--runs N] [--threshold PCT] [--cpus a,b,...] [--hitm-event RAW]
+//   [--update]
+// --cpus is the affinity mask of every benchmark, it has to hold every cpu
+// one of them pins a thread on. --update writes the results as the new
+// baseline instead of comparing
+Options parseOptions(int argc, const char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto next = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::runtime_error(arg + " needs a value");
+      }
+      return argv[++i];
+    };
+    if (arg == "--manifest") {
+      options.manifest = next();
+    } else if (arg == "--baseline") {
+      options.baseline = next();
+    } else if (arg == "--output") {
+      options.output = next();
+    } else if (arg == "--runs") {
+      options.runs = std::max(1, std::atoi(next().c_str()));
+    } else if (arg == "--threshold") {
+      options.threshold = std::atof(next().c_str());
+    } else if (arg == "--cpus") {
+      for (auto& cpu : split(next(), ',')) {
+        options.cpus.push_back(std::atoi(cpu.c_str()));
+      }
+    } else if (arg == "--hitm-event") {
+      auto event = next();
+      options.hitmEvent = event.empty() || event == "none"
+                              ? std::nullopt
+                              : std::optional{std::stoull(event, nullptr, 0)};
+    } else if (arg == "--update") {
+      options.update = true;
+    } else {
+      throw std::runtime_error("unknown option: " + arg);
+    }
+  }
+  if (options.manifest.empty() || options.baseline.empty()) {
+    throw std::runtime_error("--manifest and --baseline are required");
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  try {
+    auto options = parseOptions(argc, argv);
+    auto results = runAll(readManifest(options.manifest), options);
+    if (!options.output.empty()) {
+      writeJson(results, options.output);
+    }
+    if (options.update) {
+      writeJson(results, options.baseline);
+      std::cout << "baseline written to " << options.baseline << "\n";
+      return EXIT_SUCCESS;
+    }
+    if (!std::ifstream{options.baseline}) {
+      compare(results, {}, options.threshold);
+      std::cout << "no baseline at " << options.baseline
+                << ", build fifo_bench_baseline to record one\n";
+      return EXIT_SUCCESS;
+    }
+    if (!compare(results, readJson(options.baseline), options.threshold)) {
+      std::cout << "throughput regressed by more than " << options.threshold
+                << "%\n";
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  } catch (const std::exception& e) {
+    std::cerr << "bench_all: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
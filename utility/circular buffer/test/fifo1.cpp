@@ -1,7 +1,14 @@
 #include "fifo1.hpp"
 #include "benchmark/bench.hpp"
 
+template <class Tp>
+using Fifo1Mod = Fifo1<Tp, std::allocator<Tp>, ModuloCapacity>;
+template <class Tp>
+using Fifo1Fix = Fifo1<Tp, std::allocator<Tp>, FixedCapacity<kBenchFifoSize>>;
+
 int main(int argc, const char* argv[]) {
    bench<Fifo1>("Fifo1", argc, argv);
+   bench<Fifo1Mod>("Fifo1Mod", argc, argv);
+   bench<Fifo1Fix>("Fifo1Fix", argc, argv);
    return 0;
 }
\ No newline at end of file
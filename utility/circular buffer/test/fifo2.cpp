@@ -1,7 +1,14 @@
 #include "fifo2.hpp"
 #include "benchmark/bench.hpp"
 
+template <class Tp>
+using Fifo2Mod = Fifo2<Tp, std::allocator<Tp>, ModuloCapacity>;
+template <class Tp>
+using Fifo2Fix = Fifo2<Tp, std::allocator<Tp>, FixedCapacity<kBenchFifoSize>>;
+
 int main(int argc, const char* argv[]) {
    bench<Fifo2>("Fifo2", argc, argv);
+   bench<Fifo2Mod>("Fifo2Mod", argc, argv);
+   bench<Fifo2Fix>("Fifo2Fix", argc, argv);
    return 0;
 }
\ No newline at end of file
@@ -1,7 +1,14 @@
 #include "fifo3.hpp"
 #include "benchmark/bench.hpp"
 
+template <class Tp>
+using Fifo3Mod = Fifo3<Tp, std::allocator<Tp>, ModuloCapacity>;
+template <class Tp>
+using Fifo3Fix = Fifo3<Tp, std::allocator<Tp>, FixedCapacity<kBenchFifoSize>>;
+
 int main(int argc, const char* argv[]) {
    bench<Fifo3>("Fifo3", argc, argv);
+   bench<Fifo3Mod>("Fifo3Mod", argc, argv);
+   bench<Fifo3Fix>("Fifo3Fix", argc, argv);
    return 0;
 }
\ No newline at end of file
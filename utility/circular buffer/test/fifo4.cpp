@@ -1,7 +1,33 @@
 #include "fifo4.hpp"
+#include "huge_page_allocator.hpp"
 #include "benchmark/bench.hpp"
 
+template <class Tp>
+using Fifo4Mod = Fifo4<Tp, std::allocator<Tp>, ModuloCapacity>;
+template <class Tp>
+using Fifo4Fix = Fifo4<Tp, std::allocator<Tp>, FixedCapacity<kBenchFifoSize>>;
+template <class Tp>
+using Fifo4Wait = Fifo4<Tp, std::allocator<Tp>, PowerOfTwoCapacity, FutexWait>;
+template <class Tp>
+using Fifo4Huge = Fifo4<Tp, HugePageNumaAlloc<Tp>>;
+template <class Tp>
+using Fifo4Lazy16 = Fifo4<Tp, std::allocator<Tp>, PowerOfTwoCapacity, NoWait, 16>;
+template <class Tp>
+using Fifo4Lazy64 = Fifo4<Tp, std::allocator<Tp>, PowerOfTwoCapacity, NoWait, 64>;
+template <class Tp>
+using Fifo4Stats =
+    Fifo4<Tp, std::allocator<Tp>, PowerOfTwoCapacity, NoWait, 1, FifoStats>;
+
 int main(int argc, const char* argv[]) {
    bench<Fifo4>("Fifo4", argc, argv);
+   bench<Fifo4Mod>("Fifo4Mod", argc, argv);
+   bench<Fifo4Fix>("Fifo4Fix", argc, argv);
+   bench<Fifo4Wait>("Fifo4Wait", argc, argv);
+   bench<Fifo4Lazy16>("Fifo4Lazy16", argc, argv);
+   bench<Fifo4Lazy64>("Fifo4Lazy64", argc, argv);
+   bench<Fifo4Stats>("Fifo4Stats", argc, argv);
+   if (parseBenchOptions(argc, argv).hugePages) {
+      bench<Fifo4Huge>("Fifo4Huge", argc, argv);
+   }
    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "fifo4.hpp"
+#include "benchmark/async.hpp"
+
+// usage: fifo_async [consumers [workers [cpu]]], the producer thread is
+// pinned on cpu, the consumer coroutines run on workers threads
+int main(int argc, const char* argv[]) {
+   size_t consumers = 256;
+   size_t workers = std::thread::hardware_concurrency();
+   int cpu = -1;
+   if (argc >= 2) {
+      consumers = std::atoi(argv[1]);
+   }
+   if (argc >= 3) {
+      workers = std::atoi(argv[2]);
+   }
+   if (argc >= 4) {
+      cpu = std::atoi(argv[3]);
+   }
+   constexpr long iters = 100'000;
+   using value_type = std::int64_t;
+   using Fifo4Async = Fifo4<value_type, std::allocator<value_type>,
+                            PowerOfTwoCapacity, CoroutineWait>;
+   using Fifo4AsyncLazy16 = Fifo4<value_type, std::allocator<value_type>,
+                                  PowerOfTwoCapacity, CoroutineWait, 16>;
+   for (size_t sz : {64, 1024}) {
+      auto suffix = "/" + std::to_string(sz);
+      benchAsync<Fifo4Async>("Fifo4Async" + suffix, sz, 1, workers, iters * 10,
+                             cpu);
+      benchAsync<Fifo4Async>("Fifo4Async" + suffix, sz, consumers, workers,
+                             iters, cpu);
+      benchAsync<Fifo4AsyncLazy16>("Fifo4AsyncLazy16" + suffix, sz, consumers,
+                                   workers, iters, cpu);
+   }
+   return 0;
+}
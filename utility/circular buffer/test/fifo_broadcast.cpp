@@ -0,0 +1,33 @@
+#include "fifo4.hpp"
+#include "fifo_broadcast.hpp"
+#include "benchmark/broadcast.hpp"
+
+// usage: fifo_broadcast [readers [cpu...]], the writer is pinned on the first
+// cpu and the readers round-robin on the others
+int main(int argc, const char* argv[]) {
+   size_t readers = 8;
+   std::vector<int> cpus;
+   if (argc >= 2) {
+      readers = std::atoi(argv[1]);
+   }
+   for (int i = 2; i < argc; ++i) {
+      cpus.push_back(std::atoi(argv[i]));
+   }
+   constexpr long iters = 10'000'000;
+   using value_type = std::int64_t;
+   {
+      Fanout<Fifo4<value_type>> queue{kBenchFifoSize, readers};
+      benchBroadcast("Fifo4xN", queue, iters, cpus);
+   }
+   {
+      FifoBroadcast<value_type> queue{kBenchFifoSize, readers};
+      benchBroadcast("FifoBroadcast", queue, iters, cpus);
+   }
+   {
+      FifoBroadcast<value_type, std::allocator<value_type>, PowerOfTwoCapacity,
+                    OverwriteOnLag>
+          queue{kBenchFifoSize, readers};
+      benchBroadcast("FifoBroadcastLossy", queue, iters, cpus);
+   }
+   return 0;
+}
@@ -0,0 +1,17 @@
+#include "fifo4.hpp"
+#include "benchmark/bulk.hpp"
+
+// usage: fifo_bulk [cpu1 cpu2], FIFO_BULK_COPY=scalar|avx2|avx512 forces the
+// copy implementation. OpaquePayload is the per-element copy loop
+int main(int argc, const char* argv[]) {
+   auto [cpu1, cpu2, hugePages] = parseBenchOptions(argc, argv);
+   constexpr long iters = 50'000'000;
+   std::cout << "bulk copy: " << bulkCopyIsa() << "\n";
+   benchBulk<Fifo4, Payload<8>>("Fifo4/8B", iters, cpu1, cpu2);
+   benchBulk<Fifo4, OpaquePayload<8>>("Fifo4/8B/loop", iters, cpu1, cpu2);
+   benchBulk<Fifo4, Payload<16>>("Fifo4/16B", iters, cpu1, cpu2);
+   benchBulk<Fifo4, OpaquePayload<16>>("Fifo4/16B/loop", iters, cpu1, cpu2);
+   benchBulk<Fifo4, Payload<64>>("Fifo4/64B", iters, cpu1, cpu2);
+   benchBulk<Fifo4, OpaquePayload<64>>("Fifo4/64B/loop", iters, cpu1, cpu2);
+   return 0;
+}
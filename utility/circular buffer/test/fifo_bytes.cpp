@@ -0,0 +1,42 @@
+#include "fifo4.hpp"
+#include "fifo_bytes.hpp"
+#include "benchmark/mixed.hpp"
+
+// an empty record is refused by a full ring like any other
+void checkEmptyRecord() {
+   FifoBytes<> ring{64};
+   std::byte payload[8]{};
+   while (ring.push(payload)) {
+   }
+   auto size = ring.size();
+   if (ring.push(std::span<const std::byte>{}) || ring.size() != size) {
+      throw std::runtime_error("empty record pushed into a full ring");
+   }
+   while (ring.try_pop([](auto) {})) {
+   }
+   if (!ring.push(std::span<const std::byte>{}) ||
+       !ring.try_pop([](auto record) {
+          if (!record.empty()) {
+             throw std::runtime_error("empty record read back with data");
+          }
+       })) {
+      throw std::runtime_error("empty record lost");
+   }
+}
+
+int main(int argc, const char* argv[]) {
+   int cpu1 = 1;
+   int cpu2 = 2;
+   if (argc == 3) {
+      cpu1 = std::atoi(argv[1]);
+      cpu2 = std::atoi(argv[2]);
+   }
+   checkEmptyRecord();
+   constexpr long iters = 20'000'000;
+   MixedBench bench;
+   Fifo4<MixedFrame> frames{MixedBench::kRingBytes / sizeof(MixedFrame)};
+   report("Fifo4/mixed", bench(frames, iters, cpu1, cpu2));
+   FifoBytes<> bytes{MixedBench::kRingBytes};
+   report("FifoBytes/mixed", bench(bytes, iters, cpu1, cpu2));
+   return 0;
+}
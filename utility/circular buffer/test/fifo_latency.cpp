@@ -0,0 +1,28 @@
+#include "fifo2.hpp"
+#include "fifo3.hpp"
+#include "fifo4.hpp"
+#include "fifo_mpmc.hpp"
+#include "benchmark/latency.hpp"
+
+template <class Tp>
+using Fifo4Lazy16 = Fifo4<Tp, std::allocator<Tp>, PowerOfTwoCapacity, NoWait, 16>;
+template <class Tp>
+using Fifo4Lazy64 = Fifo4<Tp, std::allocator<Tp>, PowerOfTwoCapacity, NoWait, 64>;
+
+// Fifo1 is not thread safe, it has no place in a two threads benchmark
+int main(int argc, const char* argv[]) {
+   auto options = parseLatencyOptions(argc, argv);
+   LatencyReport report{options.format};
+   for (const auto& pair : options.pairs) {
+      benchLatency<Fifo2, 8, 16, 64, 256, 1024>("Fifo2", pair, options, report);
+      benchLatency<Fifo3, 8, 16, 64, 256, 1024>("Fifo3", pair, options, report);
+      benchLatency<Fifo4, 8, 16, 64, 256, 1024>("Fifo4", pair, options, report);
+      benchLatency<Fifo4Lazy16, 8, 16, 64, 256, 1024>("Fifo4Lazy16", pair,
+                                                      options, report);
+      benchLatency<Fifo4Lazy64, 8, 16, 64, 256, 1024>("Fifo4Lazy64", pair,
+                                                      options, report);
+      benchLatency<FifoMpmc, 8, 16, 64, 256, 1024>("FifoMpmc", pair, options,
+                                                   report);
+   }
+   return 0;
+}
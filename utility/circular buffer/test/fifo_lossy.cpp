@@ -0,0 +1,30 @@
+#include "fifo_lossy.hpp"
+#include "benchmark/lossy.hpp"
+
+// usage: fifo_lossy [consumers [cpu...]], the producer is pinned on the
+// first cpu and the consumers round-robin on the others
+int main(int argc, const char* argv[]) {
+   size_t consumers = 2;
+   std::vector<int> cpus;
+   if (argc >= 2) {
+      consumers = std::atoi(argv[1]);
+   }
+   for (int i = 2; i < argc; ++i) {
+      cpus.push_back(std::atoi(argv[i]));
+   }
+   constexpr long iters = 10'000'000;
+   using value_type = std::int64_t;
+   for (long work : {0, 100}) {
+      {
+         FifoLossy<value_type> queue{kBenchFifoSize};
+         benchLossy("FifoLossy", queue, iters, 1, work, cpus);
+      }
+      {
+         FifoLossy<value_type, std::allocator<value_type>, PowerOfTwoCapacity,
+                   MultiConsumer>
+             queue{kBenchFifoSize};
+         benchLossy("FifoLossyMC", queue, iters, consumers, work, cpus);
+      }
+   }
+   return 0;
+}
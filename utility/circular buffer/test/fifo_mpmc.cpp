@@ -0,0 +1,27 @@
+#include "fifo_mpmc.hpp"
+#include "benchmark/bench.hpp"
+
+// a ring asked for one slot still refuses a push into a full ring
+void checkSingleSlot() {
+   FifoMpmc<int> fifo{1};
+   auto pushed = 0;
+   while (fifo.push(pushed) && pushed < 8) {
+      ++pushed;
+   }
+   if (static_cast<std::size_t>(pushed) != fifo.capacity() ||
+       fifo.size() != fifo.capacity()) {
+      throw std::runtime_error("push into a full ring accepted");
+   }
+   for (auto i = 0; i < pushed; ++i) {
+      int value = -1;
+      if (!fifo.pop(value) || value != i) {
+         throw std::runtime_error("element lost");
+      }
+   }
+}
+
+int main(int argc, const char* argv[]) {
+   checkSingleSlot();
+   benchMulti<FifoMpmc>("FifoMpmc", argc, argv);
+   return 0;
+}
\ No newline at end of file
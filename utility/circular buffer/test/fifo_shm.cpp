@@ -0,0 +1,119 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+
+#include "fifo_shm.hpp"
+#include "benchmark/bench.hpp"
+
+// a producer and a consumer attaching to a ring which was used already
+// have to start from its cursors, not from 0
+void checkReattach(const std::string& name) {
+   using value_type = std::int64_t;
+   auto fail = [&](const char* what) {
+      FifoShm<value_type>::unlink(name);
+      throw std::runtime_error(std::string{"reattach: "} + what);
+   };
+   auto ring = FifoShm<value_type>::create(name, 4);
+   value_type value;
+   for (value_type i = 0; i < 3; ++i) {
+      ring.push(i);
+   }
+   for (value_type i = 0; i < 3; ++i) {
+      ring.pop(value);
+   }
+   {
+      // drained: nothing to pop
+      auto consumer = FifoShm<value_type>::attach(name);
+      if (consumer.pop(value) || consumer.size() != 0) {
+         fail("consumer popped from a drained ring");
+      }
+   }
+   for (value_type i = 0; i < 4; ++i) {
+      ring.push(10 + i);
+   }
+   {
+      // full: the unread values stay
+      auto producer = FifoShm<value_type>::attach(name);
+      if (producer.push(-1) || producer.size() != 4) {
+         fail("producer overwrote unread values");
+      }
+   }
+   {
+      auto consumer = FifoShm<value_type>::attach(name);
+      for (value_type i = 0; i < 4; ++i) {
+         if (!consumer.pop(value) || value != 10 + i) {
+            fail("consumer lost a value");
+         }
+      }
+      if (consumer.pop(value)) {
+         fail("consumer popped past the producer");
+      }
+   }
+   FifoShm<value_type>::unlink(name);
+}
+
+// the consumer is a forked process attaching to the ring by name
+int main(int argc, const char* argv[]) {
+   using namespace std::chrono_literals;
+   int cpu1 = 1;
+   int cpu2 = 2;
+   if (argc == 3) {
+      cpu1 = std::atoi(argv[1]);
+      cpu2 = std::atoi(argv[2]);
+   }
+   constexpr long iters = 100'000'000;
+   using value_type = std::int64_t;
+   auto name = "/fifo_shm." + std::to_string(::getpid());
+   checkReattach(name);
+   auto queue = FifoShm<value_type>::create(name, kBenchFifoSize);
+   auto pop = [](FifoShm<value_type>& peer, value_type expected) {
+      value_type value;
+      while (auto again = !peer.pop(value)) {
+         doNotOptimize(again);
+      }
+      if (value != expected) {
+         std::_Exit(EXIT_FAILURE);
+      }
+   };
+   auto push = [&](value_type value) {
+      while (auto again = !queue.push(value)) {
+         doNotOptimize(again);
+      }
+   };
+   auto waitForEmpty = [&] {
+      while (auto again = !queue.empty()) {
+         doNotOptimize(again);
+      }
+   };
+   auto pid = ::fork();
+   if (pid == 0) {
+      pinThread(cpu1);
+      auto peer = FifoShm<value_type>::attach(name);
+      for (size_t i = 0; i < kBenchFifoSize; ++i) {
+         pop(peer, static_cast<value_type>(i));
+      }
+      for (auto i = value_type{}; i < iters; ++i) {
+         pop(peer, i);
+      }
+      std::_Exit(EXIT_SUCCESS);
+   }
+   pinThread(cpu2);
+   for (size_t i = 0; i < kBenchFifoSize; ++i) {
+      push(static_cast<value_type>(i));
+   }
+   waitForEmpty();
+   auto start = std::chrono::steady_clock::now();
+   for (auto i = value_type{}; i < iters; ++i) {
+      push(i);
+   }
+   waitForEmpty();
+   auto end = std::chrono::steady_clock::now();
+   int status = 0;
+   ::waitpid(pid, &status, 0);
+   FifoShm<value_type>::unlink(name);
+   if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      throw std::runtime_error("invalid value");
+   }
+   report("FifoShm", (1s * iters) / (end - start));
+   return 0;
+}
@@ -0,0 +1,16 @@
+#include "basic_fifo.hpp"
+#include "benchmark/sweep.hpp"
+
+// every combination of cursors, padding, caching, batching and capacity
+// of BasicFifo. PlainCursors is left out, it is not thread safe at all
+int main(int argc, const char* argv[]) {
+   auto [cpu1, cpu2, hugePages] = parseBenchOptions(argc, argv);
+   constexpr long iters = 10'000'000;
+   sweep(SweepBench{iters, cpu1, cpu2},
+         PolicyList<SeqCstCursors, AcqRelCursors>{},
+         PolicyList<Padding<false>, Padding<true>>{},
+         PolicyList<Caching<false>, Caching<true>>{},
+         PolicyList<Batching<false>, Batching<true>>{},
+         PolicyList<ModuloCapacity, PowerOfTwoCapacity>{});
+   return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef BENCHMARK_ASYNC_HPP_
+#define BENCHMARK_ASYNC_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmark/bench.hpp"
+#include "scheduler.hpp"
+
+// one producer thread streams 0, 1, 2... into one FIFO per consumer, the
+// consumers are coroutines of the multi-threads example Scheduler which
+// co_await async_pop() and get resumed by the producer when they ran dry
+template <class Fifo>
+class AsyncBench {
+ public:
+  using value_type = typename Fifo::value_type;
+
+  struct Result {
+    long opsPerSec;
+  };
+
+  Result operator()(size_t sz,
+                    size_t consumers,
+                    size_t workers,
+                    long iters,
+                    int cpu) {
+    using namespace std::chrono_literals;
+    Scheduler sch{workers};
+    std::vector<std::unique_ptr<Fifo>> queues;
+    std::atomic<long> errors{0};
+    for (size_t c = 0; c < consumers; ++c) {
+      queues.push_back(std::make_unique<Fifo>(sz));
+      sch.add_task(consume(*queues.back(), sch, iters, errors).get_handle());
+    }
+    pinThread(cpu);
+    auto start = std::chrono::steady_clock::now();
+    sch.schedule();
+    for (value_type i = 0; i < iters; ++i) {
+      for (auto& queue : queues) {
+        while (auto again = !queue->push(i)) {
+          doNotOptimize(again);
+        }
+      }
+    }
+    for (auto& queue : queues) {
+      queue->flush_push();
+    }
+    sch.wait();
+    auto end = std::chrono::steady_clock::now();
+    if (errors.load() != 0) {
+      throw std::runtime_error("invalid value");
+    }
+    return {(1s * iters * static_cast<long>(consumers)) / (end - start)};
+  }
+
+ private:
+  static Task consume(Fifo& queue,
+                      Scheduler& sch,
+                      long iters,
+                      std::atomic<long>& errors) {
+    for (value_type i = 0; i < iters; ++i) {
+      auto value = co_await queue.async_pop(sch);
+      if (value != i) {
+        errors.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+};
+
+// report the messages per second one producer thread delivers to the
+// consumer coroutines
+template <class Fifo>
+void benchAsync(const std::string& name,
+                size_t sz,
+                size_t consumers,
+                size_t workers,
+                long iters,
+                int cpu) {
+  auto [opsPerSec] = AsyncBench<Fifo>{}(sz, consumers, workers, iters, cpu);
+  report(name + "/" + std::to_string(consumers), opsPerSec);
+}
+
+#endif  // BENCHMARK_ASYNC_HPP_
@@ -2,15 +2,19 @@
 #define BENCHMARK_BENCH_HPP_
 
 #include <sched.h>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <stdexcept>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <pthread.h>
 #include <type_traits>
@@ -33,16 +37,31 @@ static void pinThread(int cpu) {
   }
 }
 
+// ring size of the benchmark, a power of two so that every capacity policy
+// ends up with the same number of slots
+inline constexpr size_t kBenchFifoSize = 131072;
+
 template <class Tp>
 struct isRigtorp : std::false_type {};
 
+// FIFO which supports push_n/pop_n
+template <class Tp>
+concept BatchFifo = requires(Tp& queue, typename Tp::value_type* p) {
+  queue.push_n(p, p);
+  queue.pop_n(p, 0);
+};
+
 template <class Tp>
 class Bench {
  public:
   using value_type = typename Tp::value_type;
-  static constexpr size_t kFifoSize = 131072;
+  static constexpr size_t kFifoSize = kBenchFifoSize;
+
+  explicit Bench(int consumerCpu = -1) : queue_{makeQueue(consumerCpu)} {}
 
-  auto operator()(long iters, int cpu1, int cpu2) {
+  // batch == 1 benchmarks the per-item push/pop, otherwise push_n/pop_n
+  // with at most batch elements per call
+  auto operator()(long iters, int cpu1, int cpu2, size_t batch = 1) {
     using namespace std::chrono_literals;
 
     auto j = std::jthread([=, this] {
@@ -52,8 +71,12 @@ class Bench {
         this->pop(i);
       }
       // pop the benchmark
-      for (auto i = value_type{}; i < iters; ++i) {
-        this->pop(i);
+      if (batch == 1) {
+        for (auto i = value_type{}; i < iters; ++i) {
+          this->pop(i);
+        }
+      } else {
+        this->popBatch(iters, batch);
       }
     });
     pinThread(cpu2);
@@ -63,14 +86,19 @@ class Bench {
     }
     waitForEmpty();
     auto start = std::chrono::steady_clock::now();
-    for (auto i = value_type{}; i < iters; ++i) {
-      push(i);
+    if (batch == 1) {
+      for (auto i = value_type{}; i < iters; ++i) {
+        push(i);
+      }
+    } else {
+      pushBatch(iters, batch);
     }
     waitForEmpty();
     auto end = std::chrono::steady_clock::now();
     auto duration = end - start;
     return (1s * iters) / duration;
   }
+  const Tp& queue() const noexcept { return queue_; }
 
  private:
   void pop(value_type expected) {
@@ -81,6 +109,8 @@ class Bench {
       }
       value = *queue_.front();
       queue_.pop();
+    } else if constexpr (requires { queue_.pop_wait(value); }) {
+      queue_.pop_wait(value);
     } else {
       while (auto again = !queue_.pop(value)) {
         doNotOptimize(again);
@@ -95,38 +125,240 @@ class Bench {
       while (auto again = !queue_.try_push(value)) {
         doNotOptimize(again);
       }
+    } else if constexpr (requires { queue_.push_wait(value); }) {
+      queue_.push_wait(value);
     } else {
       while (auto again = !queue_.push(value)) {
         doNotOptimize(again);
       }
     }
   }
+  void popBatch(long iters, size_t batch) {
+    if constexpr (BatchFifo<Tp>) {
+      std::vector<value_type> values(batch);
+      for (auto expected = value_type{}; expected < iters;) {
+        auto n = queue_.pop_n(values.data(), batch);
+        doNotOptimize(n);
+        for (size_t i = 0; i < n; ++i, ++expected) {
+          if (values[i] != expected) {
+            throw std::runtime_error("invalid value");
+          }
+        }
+      }
+    }
+  }
+  void pushBatch(long iters, size_t batch) {
+    if constexpr (BatchFifo<Tp>) {
+      std::vector<value_type> values(batch);
+      for (auto i = value_type{}; i < iters;) {
+        auto n = std::min<value_type>(batch, iters - i);
+        std::iota(values.begin(), values.begin() + n, i);
+        auto first = values.data();
+        auto last = first + n;
+        while (first != last) {
+          auto pushed = queue_.push_n(first, last);
+          doNotOptimize(pushed);
+          first += pushed;
+        }
+        i += n;
+      }
+    }
+  }
   void waitForEmpty() {
+    // a FIFO with lazy cursors holds back the last elements until flushed
+    if constexpr (requires { queue_.flush_push(); }) {
+      queue_.flush_push();
+    }
     while (auto again = !queue_.empty()) {
       doNotOptimize(again);
     }
   }
-  Tp queue_{kFifoSize};
+  // a FIFO whose allocator has an onCpu() factory gets its storage on the
+  // NUMA node of the consumer
+  static Tp makeQueue(int consumerCpu) {
+    if constexpr (requires(int cpu) { Tp::allocator_type::onCpu(cpu); }) {
+      return Tp{kFifoSize, Tp::allocator_type::onCpu(consumerCpu)};
+    } else {
+      return Tp{kFifoSize};
+    }
+  }
+  Tp queue_;
 };
 
+// the stall counters of a FIFO built with statistics
+template <class Counters>
+void report(const std::string& name, const Counters& counters) {
+  std::cout << std::setw(14) << std::left << name
+            << ":  push full " << counters.pushFull << ", pop empty "
+            << counters.popEmpty << ", pop cursor refresh "
+            << counters.popCursorRefresh << ", push cursor refresh "
+            << counters.pushCursorRefresh << ", high water "
+            << counters.highWater << "\n";
+}
+
 template <class Tp>
-auto bench(const char* name, long iters, int cpu1, int cpu2) {
-  return Bench<Tp>{}(iters, cpu1, cpu2);
+auto bench(const char* name,
+           long iters,
+           int cpu1,
+           int cpu2,
+           size_t batch = 1) {
+  Bench<Tp> bench{cpu1};
+  auto opsPerSec = bench(iters, cpu1, cpu2, batch);
+  if constexpr (requires { bench.queue().counters(); }) {
+    report(name, bench.queue().counters());
+  }
+  return opsPerSec;
 }
 
-template <template <class> class FifoT>
-void bench(const char* name, int argc, const char* argv[]) {
+struct BenchOptions {
   int cpu1 = 1;
   int cpu2 = 2;
-  if (argc == 3) {
-    cpu1 = std::atoi(argv[1]);
-    cpu2 = std::atoi(argv[2]);
+  // --hugepage: also bench the FIFO on huge pages
+  bool hugePages = false;
+};
+
+// usage: name [cpu1 cpu2] [--hugepage]
+inline BenchOptions parseBenchOptions(int argc, const char* argv[]) {
+  BenchOptions options;
+  std::vector<int> cpus;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string{argv[i]} == "--hugepage") {
+      options.hugePages = true;
+    } else {
+      cpus.push_back(std::atoi(argv[i]));
+    }
+  }
+  if (cpus.size() == 2) {
+    options.cpu1 = cpus[0];
+    options.cpu2 = cpus[1];
   }
+  return options;
+}
+
+inline void report(const std::string& name, long opsPerSec) {
+  std::cout << std::setw(14) << std::left << name << ":  " << std::setw(10)
+            << std::right << opsPerSec << " ops/s\n";
+}
+
+template <template <class> class FifoT>
+void bench(const char* name, int argc, const char* argv[]) {
+  auto [cpu1, cpu2, hugePages] = parseBenchOptions(argc, argv);
   constexpr size_t iters = 100'000'000;
   using value_type = std::int64_t;
   auto opsPerSec = bench<FifoT<value_type>>(name, iters, cpu1, cpu2);
-  std::cout << std::setw(7) << std::left << name << ":  " << std::setw(10)
-            << std::right << opsPerSec << " ops/s\n";
+  report(name, opsPerSec);
+  if constexpr (BatchFifo<FifoT<value_type>>) {
+    for (size_t batch : {32, 128, 512}) {
+      opsPerSec = bench<FifoT<value_type>>(name, iters, cpu1, cpu2, batch);
+      report(std::string{name} + "/" + std::to_string(batch), opsPerSec);
+    }
+  }
+}
+
+// N producers / M consumers benchmark, producer p pushes p, p + N, p + 2N...
+// so every consumer can check the per-producer order and the total sum
+template <class Tp>
+class MultiBench {
+ public:
+  using value_type = typename Tp::value_type;
+  static constexpr size_t kFifoSize = kBenchFifoSize;
+
+  auto operator()(long iters,
+                  size_t producers,
+                  size_t consumers,
+                  const std::vector<int>& cpus) {
+    using namespace std::chrono_literals;
+    auto cpu = [&](size_t idx) {
+      return cpus.empty() ? -1 : cpus[idx % cpus.size()];
+    };
+    std::atomic<value_type> sum{0};
+    std::vector<std::jthread> consumerThreads;
+    for (size_t c = 0; c < consumers; ++c) {
+      consumerThreads.emplace_back([&, c] {
+        pinThread(cpu(producers + c));
+        sum.fetch_add(this->pop(producers), std::memory_order_relaxed);
+      });
+    }
+    std::vector<std::jthread> producerThreads;
+    for (size_t p = 0; p < producers; ++p) {
+      producerThreads.emplace_back([&, p] {
+        pinThread(cpu(p));
+        while (!start_.load(std::memory_order_acquire)) {
+        }
+        this->push(p, producers, iters);
+      });
+    }
+    auto start = std::chrono::steady_clock::now();
+    start_.store(true, std::memory_order_release);
+    producerThreads.clear();
+    done_.store(true, std::memory_order_release);
+    consumerThreads.clear();
+    auto end = std::chrono::steady_clock::now();
+    if (sum != static_cast<value_type>(iters) * (iters - 1) / 2) {
+      throw std::runtime_error("invalid sum");
+    }
+    auto duration = end - start;
+    return (1s * iters) / duration;
+  }
+
+ private:
+  void push(size_t producer, size_t producers, long iters) {
+    for (auto i = static_cast<value_type>(producer); i < iters;
+         i += producers) {
+      while (auto again = !queue_.push(i)) {
+        doNotOptimize(again);
+      }
+    }
+  }
+  // return the sum of the popped values
+  value_type pop(size_t producers) {
+    std::vector<value_type> last(producers, -1);
+    value_type sum = 0;
+    value_type value;
+    while (true) {
+      if (!queue_.pop(value)) {
+        if (!done_.load(std::memory_order_acquire)) {
+          continue;
+        }
+        // no producer is left, one more try tells if the queue is drained
+        if (!queue_.pop(value)) {
+          return sum;
+        }
+      }
+      auto& prev = last[value % producers];
+      if (value <= prev) {
+        throw std::runtime_error("invalid order");
+      }
+      prev = value;
+      sum += value;
+    }
+  }
+  std::atomic<bool> start_{false};
+  std::atomic<bool> done_{false};
+  Tp queue_{kFifoSize};
+};
+
+// usage: name [producers consumers [cpu...]], threads are pinned round-robin
+// on the given cpus
+template <template <class> class FifoT>
+void benchMulti(const char* name, int argc, const char* argv[]) {
+  size_t producers = 2;
+  size_t consumers = 2;
+  std::vector<int> cpus;
+  if (argc >= 3) {
+    producers = std::atoi(argv[1]);
+    consumers = std::atoi(argv[2]);
+  }
+  for (int i = 3; i < argc; ++i) {
+    cpus.push_back(std::atoi(argv[i]));
+  }
+  constexpr size_t iters = 100'000'000;
+  using value_type = std::int64_t;
+  auto opsPerSec =
+      MultiBench<FifoT<value_type>>{}(iters, producers, consumers, cpus);
+  report(std::string{name} + "/" + std::to_string(producers) + "x" +
+             std::to_string(consumers),
+         opsPerSec);
 }
 
 #endif  // BENCHMARK_BENCH_HPP_
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef BENCHMARK_BROADCAST_HPP_
+#define BENCHMARK_BROADCAST_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/bench.hpp"
+
+// the fan-out done without a broadcast ring: one SPSC FIFO per reader, the
+// writer pushes a copy of every element into each of them
+template <class Fifo>
+class Fanout {
+ public:
+  using value_type = typename Fifo::value_type;
+
+  Fanout(size_t sz, size_t readers) {
+    for (size_t r = 0; r < readers; ++r) {
+      queues_.push_back(std::make_unique<Fifo>(sz));
+    }
+  }
+  auto readers() const noexcept { return queues_.size(); }
+  auto lost(size_t) const noexcept { return size_t{0}; }
+  auto push(const value_type& value) {
+    for (auto& queue : queues_) {
+      while (auto again = !queue->push(value)) {
+        doNotOptimize(again);
+      }
+    }
+    return true;
+  }
+  auto pop(size_t reader, value_type& value) {
+    return queues_[reader]->pop(value);
+  }
+
+ private:
+  std::vector<std::unique_ptr<Fifo>> queues_;
+};
+
+// one writer streams 0, 1, 2... to every reader. a reader checks that it
+// sees every value in order, or only an increasing sequence when the FIFO
+// may drop the elements of a lagging reader
+template <class Tp>
+class BroadcastBench {
+ public:
+  using value_type = typename Tp::value_type;
+
+  struct Result {
+    long opsPerSec;
+    size_t lost;
+  };
+
+  // cpus[0] is the writer, reader r runs on cpus[r + 1], round-robin
+  Result operator()(Tp& queue, long iters, const std::vector<int>& cpus) {
+    using namespace std::chrono_literals;
+    auto cpu = [&](size_t idx) {
+      return cpus.empty() ? -1 : cpus[idx % cpus.size()];
+    };
+    std::vector<size_t> lost(queue.readers());
+    std::vector<std::jthread> readers;
+    for (size_t r = 0; r < queue.readers(); ++r) {
+      readers.emplace_back([&, r] {
+        pinThread(cpu(r + 1));
+        lost[r] = read(queue, r, iters);
+      });
+    }
+    pinThread(cpu(0));
+    auto start = std::chrono::steady_clock::now();
+    for (value_type i = 0; i < iters; ++i) {
+      while (auto again = !queue.push(i)) {
+        doNotOptimize(again);
+      }
+    }
+    readers.clear();
+    auto end = std::chrono::steady_clock::now();
+    Result result{(1s * iters) / (end - start), 0};
+    for (auto n : lost) {
+      result.lost += n;
+    }
+    return result;
+  }
+
+ private:
+  // return the number of values the reader lost
+  static size_t read(Tp& queue, size_t reader, long iters) {
+    value_type prev = -1;
+    value_type value;
+    while (prev != iters - 1) {
+      if (!queue.pop(reader, value)) {
+        continue;
+      }
+      auto lost = queue.lost(reader);
+      if (value <= prev || (lost == 0 && value != prev + 1)) {
+        throw std::runtime_error("invalid value");
+      }
+      prev = value;
+    }
+    return queue.lost(reader);
+  }
+};
+
+// report the throughput of one writer to queue.readers() readers
+template <class Tp>
+void benchBroadcast(const char* name,
+                    Tp& queue,
+                    long iters,
+                    const std::vector<int>& cpus) {
+  auto [opsPerSec, lost] = BroadcastBench<Tp>{}(queue, iters, cpus);
+  auto label = std::string{name} + "/" + std::to_string(queue.readers());
+  report(label, opsPerSec);
+  if (lost != 0) {
+    std::cout << label << ":  " << lost << " lost\n";
+  }
+}
+
+#endif  // BENCHMARK_BROADCAST_HPP_
@@ -0,0 +1,86 @@
+#ifndef BENCHMARK_BULK_HPP_
+#define BENCHMARK_BULK_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/bench.hpp"
+#include "benchmark/latency.hpp"
+
+// same layout as Payload<N> but not trivially copyable, so the FIFO falls
+// back to its per-element copy loop
+template <size_t N>
+struct OpaquePayload : Payload<N> {
+  OpaquePayload() = default;
+  OpaquePayload(const OpaquePayload& other) : Payload<N>(other) {}
+  OpaquePayload& operator=(const OpaquePayload& other) {
+    Payload<N>::operator=(other);
+    return *this;
+  }
+};
+
+// batches of push_n/pop_n of Tp with a sequence number, the consumer checks
+// the order
+template <class Fifo>
+class BulkBench {
+ public:
+  using value_type = typename Fifo::value_type;
+
+  long operator()(long iters, int cpu1, int cpu2, size_t batch) {
+    using namespace std::chrono_literals;
+    auto j = std::jthread([=, this] {
+      pinThread(cpu1);
+      std::vector<value_type> values(batch);
+      for (std::uint64_t expected = 0;
+           expected < static_cast<std::uint64_t>(iters);) {
+        auto n = queue_.pop_n(values.data(), batch);
+        doNotOptimize(n);
+        for (size_t i = 0; i < n; ++i, ++expected) {
+          if (values[i].seq != expected) {
+            throw std::runtime_error("invalid value");
+          }
+        }
+      }
+    });
+    pinThread(cpu2);
+    std::vector<value_type> values(batch);
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < static_cast<std::uint64_t>(iters);) {
+      auto n = std::min<std::uint64_t>(batch, iters - i);
+      for (size_t k = 0; k < n; ++k) {
+        values[k].seq = i + k;
+      }
+      auto first = values.data();
+      auto last = first + n;
+      while (first != last) {
+        auto pushed = queue_.push_n(first, last);
+        doNotOptimize(pushed);
+        first += pushed;
+      }
+      i += n;
+    }
+    j.join();
+    auto end = std::chrono::steady_clock::now();
+    return (1s * iters) / (end - start);
+  }
+
+ private:
+  Fifo queue_{kBenchFifoSize};
+};
+
+// one line per batch size for FifoT<Tp>
+template <template <class> class FifoT, class Tp>
+void benchBulk(const std::string& name, long iters, int cpu1, int cpu2) {
+  for (size_t batch : {32, 512, 4096}) {
+    report(name + "/" + std::to_string(batch),
+           BulkBench<FifoT<Tp>>{}(iters, cpu1, cpu2, batch));
+  }
+}
+
+#endif  // BENCHMARK_BULK_HPP_
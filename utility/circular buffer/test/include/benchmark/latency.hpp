@@ -0,0 +1,313 @@
+#ifndef BENCHMARK_LATENCY_HPP_
+#define BENCHMARK_LATENCY_HPP_
+
+#include <sched.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark/bench.hpp"
+#include "latency_histogram.hpp"
+
+// fixed size message, seq is checked by the receiver
+template <size_t N>
+struct Payload {
+  static_assert(N > sizeof(std::uint64_t), "payload holds at least seq");
+  std::uint64_t seq;
+  char data[N - sizeof(std::uint64_t)];
+};
+template <>
+struct Payload<sizeof(std::uint64_t)> {
+  std::uint64_t seq;
+};
+
+struct CpuPair {
+  std::string kind;
+  int cpu1;
+  int cpu2;
+};
+
+namespace detail {
+inline int readTopology(int cpu, const char* name) {
+  auto path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+              "/topology/" + name;
+  std::ifstream in{path};
+  int value = -1;
+  in >> value;
+  return in ? value : -1;
+}
+}  // namespace detail
+
+// one pair of each kind among the cpus we may run on: SMT siblings of the
+// same core, two cores of the same socket, two sockets. falls back to an
+// unpinned pair when the topology is not readable
+inline std::vector<CpuPair> cpuPairs() {
+  struct Cpu {
+    int id;
+    int core;
+    int socket;
+  };
+  std::vector<Cpu> cpus;
+  ::cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (::sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (!CPU_ISSET(cpu, &allowed)) {
+        continue;
+      }
+      auto core = detail::readTopology(cpu, "core_id");
+      auto socket = detail::readTopology(cpu, "physical_package_id");
+      if (core >= 0 && socket >= 0) {
+        cpus.push_back({cpu, core, socket});
+      }
+    }
+  }
+  std::vector<CpuPair> pairs;
+  auto find = [&](const char* kind, auto match) {
+    for (size_t i = 0; i < cpus.size(); ++i) {
+      for (size_t j = i + 1; j < cpus.size(); ++j) {
+        if (match(cpus[i], cpus[j])) {
+          pairs.push_back({kind, cpus[i].id, cpus[j].id});
+          return;
+        }
+      }
+    }
+  };
+  find("smt", [](const Cpu& a, const Cpu& b) {
+    return a.socket == b.socket && a.core == b.core;
+  });
+  find("socket", [](const Cpu& a, const Cpu& b) {
+    return a.socket == b.socket && a.core != b.core;
+  });
+  find("cross", [](const Cpu& a, const Cpu& b) { return a.socket != b.socket; });
+  if (pairs.empty()) {
+    pairs.push_back({"unpinned", -1, -1});
+  }
+  return pairs;
+}
+
+struct LatencyResult {
+  std::string fifo;
+  CpuPair pair;
+  size_t payload;
+  long opsPerSec;
+  LatencyHistogram rtt;
+  LatencyHistogram stream;
+};
+
+// round trip: cpu1 pushes into ping, cpu2 echoes it back through pong, one
+// message in flight. throughput: cpu1 streams into ping, cpu2 drains it,
+// every kStreamSample-th message also gives a one-way latency under load
+template <template <class> class FifoT, size_t N>
+class LatencyBench {
+ public:
+  using value_type = Payload<N>;
+  static constexpr size_t kFifoSize = 1024;
+  static constexpr std::uint64_t kStreamSample = 64;
+
+  LatencyResult operator()(const char* name,
+                           const CpuPair& pair,
+                           long samples,
+                           long iters) {
+    LatencyResult result{name, pair, N, 0, {}, {}};
+    roundTrip(pair, samples, result.rtt);
+    result.opsPerSec = throughput(pair, iters, result.stream);
+    return result;
+  }
+
+ private:
+  static void pop(FifoT<value_type>& queue, std::uint64_t expected) {
+    value_type value;
+    while (auto again = !queue.pop(value)) {
+      doNotOptimize(again);
+    }
+    if (value.seq != expected) {
+      throw std::runtime_error("invalid value");
+    }
+  }
+  static void push(FifoT<value_type>& queue, std::uint64_t seq) {
+    value_type value;
+    value.seq = seq;
+    while (auto again = !queue.push(value)) {
+      doNotOptimize(again);
+    }
+  }
+  // a FIFO with lazy cursors holds back the last elements until flushed
+  static void flush(FifoT<value_type>& queue) {
+    if constexpr (requires { queue.flush_push(); }) {
+      queue.flush_push();
+    }
+  }
+  void roundTrip(const CpuPair& pair, long samples, LatencyHistogram& rtt) {
+    auto warm = std::min<long>(samples, kFifoSize);
+    auto total = static_cast<std::uint64_t>(warm + samples);
+    auto j = std::jthread([=, this] {
+      pinThread(pair.cpu2);
+      for (std::uint64_t i = 0; i < total; ++i) {
+        pop(ping_, i);
+        push(pong_, i);
+        flush(pong_);
+      }
+    });
+    pinThread(pair.cpu1);
+    for (std::uint64_t i = 0; i < total; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      push(ping_, i);
+      flush(ping_);
+      pop(pong_, i);
+      auto end = std::chrono::steady_clock::now();
+      if (i >= static_cast<std::uint64_t>(warm)) {
+        rtt.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       end - start)
+                       .count());
+      }
+    }
+  }
+  long throughput(const CpuPair& pair, long iters, LatencyHistogram& stream) {
+    using namespace std::chrono_literals;
+    using clock = std::chrono::steady_clock;
+    auto total = static_cast<std::uint64_t>(iters);
+    std::vector<clock::time_point> sent(total / kStreamSample + 1);
+    std::vector<clock::time_point> received(sent.size());
+    auto j = std::jthread([&, this] {
+      pinThread(pair.cpu2);
+      for (std::uint64_t i = 0; i < total; ++i) {
+        pop(ping_, i);
+        if (i % kStreamSample == 0) {
+          received[i / kStreamSample] = clock::now();
+        }
+      }
+    });
+    pinThread(pair.cpu1);
+    auto start = clock::now();
+    for (std::uint64_t i = 0; i < total; ++i) {
+      if (i % kStreamSample == 0) {
+        sent[i / kStreamSample] = clock::now();
+      }
+      push(ping_, i);
+    }
+    flush(ping_);
+    j.join();
+    auto end = clock::now();
+    for (std::uint64_t i = 0; i < total; i += kStreamSample) {
+      auto idx = i / kStreamSample;
+      stream.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        received[idx] - sent[idx])
+                        .count());
+    }
+    return (1s * iters) / (end - start);
+  }
+  FifoT<value_type> ping_{kFifoSize};
+  FifoT<value_type> pong_{kFifoSize};
+};
+
+// writes the results as csv or as a json array
+class LatencyReport {
+ public:
+  enum class Format { kCsv, kJson };
+  explicit LatencyReport(Format format, std::ostream& out = std::cout)
+      : format_{format}, out_{out} {
+    if (format_ == Format::kCsv) {
+      out_ << "fifo,pair,cpu1,cpu2,payload,ops_per_sec,samples,"
+              "min_ns,p50_ns,p99_ns,p999_ns,max_ns,"
+              "stream_p50_ns,stream_p99_ns,stream_p999_ns\n";
+    } else {
+      out_ << "[";
+    }
+  }
+  LatencyReport(const LatencyReport&) = delete;
+  LatencyReport& operator=(const LatencyReport&) = delete;
+  ~LatencyReport() {
+    if (format_ == Format::kJson) {
+      out_ << "\n]\n";
+    }
+  }
+
+  void add(const LatencyResult& r) {
+    const auto& h = r.rtt;
+    const auto& st = r.stream;
+    if (format_ == Format::kCsv) {
+      out_ << r.fifo << ',' << r.pair.kind << ',' << r.pair.cpu1 << ','
+           << r.pair.cpu2 << ',' << r.payload << ',' << r.opsPerSec << ','
+           << h.count() << ',' << h.min() << ',' << h.percentile(0.5) << ','
+           << h.percentile(0.99) << ',' << h.percentile(0.999) << ','
+           << h.max() << ',' << st.percentile(0.5) << ','
+           << st.percentile(0.99) << ',' << st.percentile(0.999) << '\n';
+    } else {
+      out_ << (first_ ? "\n" : ",\n") << R"(  {"fifo": ")" << r.fifo
+           << R"(", "pair": ")" << r.pair.kind << R"(", "cpu1": )"
+           << r.pair.cpu1 << R"(, "cpu2": )" << r.pair.cpu2
+           << R"(, "payload": )" << r.payload << R"(, "ops_per_sec": )"
+           << r.opsPerSec << R"(, "samples": )" << h.count()
+           << R"(, "min_ns": )" << h.min() << R"(, "p50_ns": )"
+           << h.percentile(0.5) << R"(, "p99_ns": )" << h.percentile(0.99)
+           << R"(, "p999_ns": )" << h.percentile(0.999) << R"(, "max_ns": )"
+           << h.max() << R"(, "stream_p50_ns": )" << st.percentile(0.5)
+           << R"(, "stream_p99_ns": )" << st.percentile(0.99)
+           << R"(, "stream_p999_ns": )" << st.percentile(0.999) << "}";
+    }
+    out_.flush();
+    first_ = false;
+  }
+
+ private:
+  Format format_;
+  std::ostream& out_;
+  bool first_ = true;
+};
+
+struct LatencyOptions {
+  LatencyReport::Format format = LatencyReport::Format::kCsv;
+  long samples = 100'000;
+  long iters = 10'000'000;
+  std::vector<CpuPair> pairs;
+};
+
+// usage: [--json] [--samples N] [--iters N] [--pair cpu1 cpu2]...
+// without --pair one pair of each topology kind is measured
+inline LatencyOptions parseLatencyOptions(int argc, const char* argv[]) {
+  LatencyOptions options;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--json") == 0) {
+      options.format = LatencyReport::Format::kJson;
+    } else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+      options.samples = std::atol(argv[++i]);
+    } else if (std::strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+      options.iters = std::atol(argv[++i]);
+    } else if (std::strcmp(argv[i], "--pair") == 0 && i + 2 < argc) {
+      auto cpu1 = std::atoi(argv[++i]);
+      auto cpu2 = std::atoi(argv[++i]);
+      options.pairs.push_back({"user", cpu1, cpu2});
+    } else {
+      std::cerr << "unknown option: " << argv[i] << "\n";
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  if (options.pairs.empty()) {
+    options.pairs = cpuPairs();
+  }
+  return options;
+}
+
+// every payload size of Ns for one FIFO on one cpu pair
+template <template <class> class FifoT, size_t... Ns>
+void benchLatency(const char* name,
+                  const CpuPair& pair,
+                  const LatencyOptions& options,
+                  LatencyReport& report) {
+  (report.add(LatencyBench<FifoT, Ns>{}(name, pair, options.samples,
+                                        options.iters)),
+   ...);
+}
+
+#endif  // BENCHMARK_LATENCY_HPP_
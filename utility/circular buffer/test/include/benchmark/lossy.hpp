@@ -0,0 +1,110 @@
+#ifndef BENCHMARK_LOSSY_HPP_
+#define BENCHMARK_LOSSY_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/bench.hpp"
+
+// one producer pushes 0, 1, 2... without ever waiting, the consumers pop
+// what is left of it. a consumer checks that it sees an increasing sequence,
+// every value popped or dropped is accounted for at the end
+template <class Tp>
+class LossyBench {
+ public:
+  using value_type = typename Tp::value_type;
+
+  struct Result {
+    long opsPerSec;
+    long popped;
+    long dropped;
+  };
+
+  // cpus[0] is the producer, consumer c runs on cpus[c + 1], round-robin.
+  // the consumers spin work times per element to fall behind on purpose
+  Result operator()(Tp& queue,
+                    long iters,
+                    size_t consumers,
+                    long work,
+                    const std::vector<int>& cpus) {
+    using namespace std::chrono_literals;
+    auto cpu = [&](size_t idx) {
+      return cpus.empty() ? -1 : cpus[idx % cpus.size()];
+    };
+    std::atomic<bool> done{false};
+    std::vector<long> popped(consumers);
+    std::vector<std::jthread> threads;
+    for (size_t c = 0; c < consumers; ++c) {
+      threads.emplace_back([&, c] {
+        pinThread(cpu(c + 1));
+        popped[c] = consume(queue, done, work);
+      });
+    }
+    pinThread(cpu(0));
+    auto start = std::chrono::steady_clock::now();
+    for (value_type i = 0; i < iters; ++i) {
+      queue.push(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    done.store(true, std::memory_order_release);
+    threads.clear();
+    Result result{(1s * iters) / (end - start), 0,
+                  static_cast<long>(queue.dropped())};
+    for (auto n : popped) {
+      result.popped += n;
+    }
+    if (result.popped + result.dropped != iters) {
+      throw std::runtime_error("values popped and dropped do not add up");
+    }
+    return result;
+  }
+
+ private:
+  // return the number of values the consumer popped
+  static long consume(Tp& queue, std::atomic<bool>& done, long work) {
+    value_type prev = -1;
+    value_type value;
+    long popped = 0;
+    while (true) {
+      // the producer is done once the flag is seen, one more pass drains it
+      auto last = done.load(std::memory_order_acquire);
+      while (queue.pop(value)) {
+        if (value <= prev) {
+          throw std::runtime_error("invalid value");
+        }
+        prev = value;
+        ++popped;
+        for (long i = 0; i < work; ++i) {
+          doNotOptimize(i);
+        }
+      }
+      if (last) {
+        return popped;
+      }
+    }
+  }
+};
+
+// report the throughput of the producer and how much of the stream the
+// consumers got
+template <class Tp>
+void benchLossy(const std::string& name,
+                Tp& queue,
+                long iters,
+                size_t consumers,
+                long work,
+                const std::vector<int>& cpus) {
+  auto [opsPerSec, popped, dropped] =
+      LossyBench<Tp>{}(queue, iters, consumers, work, cpus);
+  auto label = name + "/" + std::to_string(consumers) + "/work" +
+               std::to_string(work);
+  report(label, opsPerSec);
+  std::cout << label << ":  " << popped << " popped, " << dropped
+            << " dropped (" << (100.0 * dropped) / iters << "%)\n";
+}
+
+#endif  // BENCHMARK_LOSSY_HPP_
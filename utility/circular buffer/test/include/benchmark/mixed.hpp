@@ -0,0 +1,122 @@
+#ifndef BENCHMARK_MIXED_HPP_
+#define BENCHMARK_MIXED_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "benchmark/bench.hpp"
+
+// mixed size workload: 70% of 16..64 bytes, 25% of 64..256 bytes and 5% of
+// 256..1024 bytes frames, every frame starts with its sequence number
+inline constexpr size_t kMaxFrameSize = 1024;
+
+inline std::vector<std::uint32_t> mixedSizes(size_t count) {
+  std::vector<std::uint32_t> sizes(count);
+  std::uint64_t seed = 0x9e3779b97f4a7c15;
+  for (auto& sz : sizes) {
+    seed = seed * 6364136223846793005 + 1442695040888963407;
+    auto r = static_cast<std::uint32_t>(seed >> 33);
+    auto bucket = r % 100;
+    if (bucket < 70) {
+      sz = 16 + r % 49;
+    } else if (bucket < 95) {
+      sz = 64 + r % 193;
+    } else {
+      sz = 256 + r % (kMaxFrameSize - 256 + 1);
+    }
+  }
+  return sizes;
+}
+
+// fixed slot of the worst case frame size, the way variable frames are
+// carried by Fifo4
+struct MixedFrame {
+  std::uint32_t size;
+  std::byte data[kMaxFrameSize];
+};
+
+// Fifo4<MixedFrame> against FifoBytes on the same workload, both through
+// their zero-copy API and with the same ring footprint in bytes
+class MixedBench {
+ public:
+  static constexpr size_t kSizes = 4096;
+  static constexpr size_t kRingBytes = 4 << 20;
+
+  MixedBench() : sizes_{mixedSizes(kSizes)} {}
+
+  template <class Fifo>
+  long operator()(Fifo& queue, long iters, int cpu1, int cpu2) {
+    using namespace std::chrono_literals;
+    auto j = std::jthread([&] {
+      pinThread(cpu1);
+      for (std::uint64_t i = 0; i < static_cast<std::uint64_t>(iters); ++i) {
+        std::span<const std::byte> frame;
+        while (auto again = (frame = read(queue)).data() == nullptr) {
+          doNotOptimize(again);
+        }
+        std::uint64_t seq;
+        std::memcpy(&seq, frame.data(), sizeof(seq));
+        if (seq != i || frame.size() != sizes_[i % kSizes]) {
+          throw std::runtime_error("invalid value");
+        }
+        release(queue);
+      }
+    });
+    pinThread(cpu2);
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < static_cast<std::uint64_t>(iters); ++i) {
+      auto sz = sizes_[i % kSizes];
+      std::byte* out;
+      while (auto again = (out = reserve(queue, sz)) == nullptr) {
+        doNotOptimize(again);
+      }
+      std::memcpy(out, &i, sizeof(i));
+      std::memset(out + sizeof(i), 0, sz - sizeof(i));
+      queue.commit();
+    }
+    j.join();
+    auto end = std::chrono::steady_clock::now();
+    return (1s * iters) / (end - start);
+  }
+
+ private:
+  template <class Fifo>
+  static std::byte* reserve(Fifo& queue, std::uint32_t sz) {
+    if constexpr (requires { queue.reserve(sz).data(); }) {
+      return queue.reserve(sz).data();
+    } else {
+      auto frame = queue.reserve();
+      if (frame == nullptr) {
+        return nullptr;
+      }
+      frame->size = sz;
+      return frame->data;
+    }
+  }
+  template <class Fifo>
+  static std::span<const std::byte> read(Fifo& queue) {
+    if constexpr (requires { queue.read(); }) {
+      return queue.read();
+    } else {
+      auto frame = queue.front();
+      if (frame == nullptr) {
+        return {};
+      }
+      return {frame->data, frame->size};
+    }
+  }
+  template <class Fifo>
+  static void release(Fifo& queue) {
+    queue.release();
+  }
+  std::vector<std::uint32_t> sizes_;
+};
+
+#endif  // BENCHMARK_MIXED_HPP_
@@ -0,0 +1,97 @@
+#ifndef BENCHMARK_PERF_HPP_
+#define BENCHMARK_PERF_HPP_
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+
+// hardware counters of a child process and all its threads, through
+// perf_event_open. a counter the kernel or the cpu does not provide (no
+// PMU in a VM, perf_event_paranoid, no HITM event) is simply left out
+
+struct PerfSample {
+  std::optional<std::uint64_t> cycles;
+  std::optional<std::uint64_t> instructions;
+  std::optional<std::uint64_t> cacheMisses;
+  // loads which hit a line modified in another core's cache
+  std::optional<std::uint64_t> hitm;
+};
+
+// raw event counting the HITM loads: MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM
+// (event 0xd2, umask 0x04) on Intel since Skylake, nothing elsewhere
+inline std::optional<std::uint64_t> defaultHitmEvent() {
+  std::ifstream cpuinfo{"/proc/cpuinfo"};
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.rfind("vendor_id", 0) == 0) {
+      if (line.find("GenuineIntel") != std::string::npos) {
+        return 0x04d2;
+      }
+      return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+class PerfCounters {
+ public:
+  // count pid, which has to be stopped before its exec(): the counters
+  // start with the exec and follow its threads and children
+  PerfCounters(pid_t pid, std::optional<std::uint64_t> hitmEvent) {
+    fds_[0] = open(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds_[1] = open(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds_[2] = open(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    if (hitmEvent) {
+      fds_[3] = open(pid, PERF_TYPE_RAW, *hitmEvent);
+    }
+  }
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  ~PerfCounters() {
+    for (auto fd : fds_) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+  }
+
+  // once the process exited
+  PerfSample read() const {
+    return {value(fds_[0]), value(fds_[1]), value(fds_[2]), value(fds_[3])};
+  }
+
+ private:
+  static int open(pid_t pid, std::uint32_t type, std::uint64_t config) {
+    ::perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(
+        ::syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0));
+  }
+  static std::optional<std::uint64_t> value(int fd) {
+    std::uint64_t count;
+    if (fd < 0 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+      return std::nullopt;
+    }
+    return count;
+  }
+
+  std::array<int, 4> fds_{-1, -1, -1, -1};
+};
+
+#endif  // BENCHMARK_PERF_HPP_
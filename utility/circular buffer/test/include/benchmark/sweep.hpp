@@ -0,0 +1,96 @@
+#ifndef BENCHMARK_SWEEP_HPP_
+#define BENCHMARK_SWEEP_HPP_
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+#include "basic_fifo.hpp"
+#include "benchmark/bench.hpp"
+
+// the options of one policy of BasicFifo
+template <class... Policies>
+struct PolicyList {};
+
+template <class Policy>
+struct PolicyName;
+template <>
+struct PolicyName<PlainCursors> {
+  static constexpr const char* kName = "plain";
+};
+template <>
+struct PolicyName<SeqCstCursors> {
+  static constexpr const char* kName = "seqcst";
+};
+template <>
+struct PolicyName<AcqRelCursors> {
+  static constexpr const char* kName = "acqrel";
+};
+template <bool On>
+struct PolicyName<Padding<On>> {
+  static constexpr const char* kName = On ? "padded" : "packed";
+};
+template <bool On>
+struct PolicyName<Caching<On>> {
+  static constexpr const char* kName = On ? "cached" : "uncached";
+};
+template <bool On>
+struct PolicyName<Batching<On>> {
+  static constexpr const char* kName = On ? "batch" : "single";
+};
+template <>
+struct PolicyName<ModuloCapacity> {
+  static constexpr const char* kName = "mod";
+};
+template <>
+struct PolicyName<PowerOfTwoCapacity> {
+  static constexpr const char* kName = "pow2";
+};
+
+namespace detail {
+template <class F, class... Chosen>
+void sweep(F& f, std::tuple<Chosen...>*) {
+  f.template operator()<Chosen...>();
+}
+template <class F, class... Chosen, class... Options, class... Lists>
+void sweep(F& f,
+           std::tuple<Chosen...>*,
+           PolicyList<Options...>,
+           Lists... lists) {
+  (sweep(f, static_cast<std::tuple<Chosen..., Options>*>(nullptr), lists...),
+   ...);
+}
+}  // namespace detail
+
+// call f.template operator()<Policies...>() once for every combination of
+// one option of each list
+template <class F, class... Lists>
+void sweep(F&& f, Lists... lists) {
+  detail::sweep(f, static_cast<std::tuple<>*>(nullptr), lists...);
+}
+
+// bench BasicFifo<std::int64_t, Policies...> and report it under the names
+// of its policies
+struct SweepBench {
+  long iters;
+  int cpu1;
+  int cpu2;
+
+  template <class... Policies>
+  void operator()() const {
+    using Fifo = BasicFifo<std::int64_t, Policies...>;
+    std::string name;
+    ((name += std::string{name.empty() ? "" : "/"} +
+              PolicyName<Policies>::kName),
+     ...);
+    report(name, bench<Fifo>(name.c_str(), iters, cpu1, cpu2));
+    if constexpr (BatchFifo<Fifo>) {
+      for (size_t batch : {32, 512}) {
+        report(name + "/" + std::to_string(batch),
+               bench<Fifo>(name.c_str(), iters, cpu1, cpu2, batch));
+      }
+    }
+  }
+};
+
+#endif  // BENCHMARK_SWEEP_HPP_